@@ -53,6 +53,7 @@ extern       int   mad_tpsa_strict;
 // ctors, dtor
 ctpsa_t* mad_ctpsa_newd    (desc_t *d, ord_t mo); // if mo > d_mo, mo = d_mo
 ctpsa_t* mad_ctpsa_new     (const ctpsa_t *t, ord_t mo);
+ctpsa_t* mad_ctpsa_newr    (const ctpsa_t *t, ord_t mo); // in current region
 void     mad_ctpsa_del     (      ctpsa_t *t);
 
 // introspection
@@ -65,6 +66,7 @@ void     mad_ctpsa_copy    (const ctpsa_t *t, ctpsa_t *dst);
 void     mad_ctpsa_clear   (      ctpsa_t *t);
 void     mad_ctpsa_scalar  (      ctpsa_t *t, cnum_t v);
 void     mad_ctpsa_scalar_r(      ctpsa_t *t, num_t v_re, num_t v_im); // without complex-by-value
+idx_t    mad_ctpsa_prune   (      ctpsa_t *t, num_t eps); // zero |coef| < eps
 
 // conversion
 void     mad_ctpsa_real    (const ctpsa_t *t, struct tpsa *dst);
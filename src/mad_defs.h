@@ -40,6 +40,7 @@ typedef int32_t          ssz_t;
 typedef uint64_t         u64_t;
 typedef struct xrange    rng_t;
 typedef double           num_t;
+typedef float           fnum_t;
 typedef double _Complex cnum_t;
 
 struct xrange {
@@ -78,10 +79,12 @@ struct xrange {
 #ifdef _OPENMP
 #include <omp.h>
 #else
+#include <time.h>
 #define omp_get_num_procs()   1
 #define omp_get_num_threads() 1
 #define omp_get_max_threads() 1
 #define omp_get_thread_num()  0
+#define omp_get_wtime()       ((double)clock() / CLOCKS_PER_SEC)
 #endif
 
 // --- POSIX & WIN -----------------------------------------------------------o
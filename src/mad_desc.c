@@ -28,7 +28,19 @@
  o----------------------------------------------------------------------------o
  */
 
+#if defined(__linux__) && defined(_OPENMP)
+#define _GNU_SOURCE
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#define DESC_NUMA 1
+#else
+#define DESC_NUMA 0
+#endif
+
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
@@ -42,12 +54,26 @@
 const ord_t mad_tpsa_default   = -1;
 const ord_t mad_tpsa_same      = -2;
       int   mad_tpsa_strict    =  0;
+      int   mad_desc_numa      =  0;
+
+      desc_ttrunc_t mad_desc_ttrunc_[TPSA_DESC_NUM]; // threadprivate, see mad_desc_impl.h
 
 // --- CONSTANTS --------------------------------------------------------------
 
 const ord_t desc_max_order = CHAR_BIT * sizeof(bit_t);
 const int   desc_max_temps = sizeof(((desc_t*)0)->t)/sizeof(*((desc_t*)0)->t);
 
+// minimum number of coefficients to build the tables in parallel
+const int   desc_par_nc    = 5000;
+
+// minimum number of variables to pack the monomials in 64 bits (i.e. smaller)
+const int   desc_pack_nv   = sizeof(u64_t) + 1;
+
+// build also the tables by search (Tv, H) to verify the ranking (slow)
+#ifndef MAD_DESC_VERIFY
+#define MAD_DESC_VERIFY 0
+#endif
+
 // --- HELPERS ----------------------------------------------------------------
 
 static inline int
@@ -81,15 +107,120 @@ nxt_mono_by_unk(int n, const ord_t a[n], const idx_t sort[n], int r, int o, ord_
   }
 }
 
+// --- RANKING ----------------------------------------------------------------
+
+/**
+ Monomials are sorted by order, then by colex order (mad_mono_rcmp).
+ R[i,o,k] counts the valid monomials of the vars [0,i) of order o with knobs
+ order <= k, so the rank of m in its order is the number of monomials sharing
+ its exponents for the vars > i and having a smaller exponent for var i.
+ Ranking and unranking take O(nv+mo) without searching the tables.
+ With many vars (nv >= desc_pack_nv), the monomials are packed in 64 bits with
+ bits(var_ords[v]) bits per var when they fit, see desc_mono.
+ */
+
+static inline idx_t
+R_idx (const D *d, int i, int o, int k)
+{
+  return (i*(d->mo+1) + o)*(d->ko+1) + k;
+}
+
+static inline void
+tbl_set_R(D *d)
+{
+  assert(d && d->var_ords);
+  int nv = d->nv, nmv = d->nmv, mo = d->mo, ko = d->ko;
+  int size = (nv+1)*(mo+1)*(ko+1);
+
+  d->R = mad_malloc(size * sizeof *d->R);
+  assert(d->R);
+  d->size += size * sizeof *d->R;
+
+  idx_t *R = d->R;
+  for (int o = 0; o <= mo; ++o)
+    for (int k = 0; k <= ko; ++k)
+      R[R_idx(d,0,o,k)] = o == 0;
+
+  for (int i = 0; i < nv; ++i) {
+    int knb = i >= nmv;
+    for (int o = 0; o <= mo; ++o)
+      for (int k = 0; k <= ko; ++k) {
+        int emax = MIN(d->var_ords[i], knb ? MIN(o,k) : o);
+        idx_t cnt = 0;
+        for (int e = 0; e <= emax; ++e)
+          cnt += R[R_idx(d, i, o-e, knb ? k-e : k)];
+        R[R_idx(d,i+1,o,k)] = cnt;
+      }
+  }
+}
+
+static inline idx_t
+mono_rank(const D *d, int n, const ord_t m[n])
+{
+  assert(d && d->R && m);
+  const idx_t *R = d->R;
+  int o = mad_mono_ord(n,m), k = d->ko, nmv = d->nmv;
+  idx_t I = d->ord2idx[o];
+  for (int i = n-1; i >= 0; --i) {
+    int knb = i >= nmv;
+    for (int e = 0; e < m[i]; ++e)
+      I += R[R_idx(d, i, o-e, knb ? k-e : k)];
+    o -= m[i];
+    if (knb) k -= m[i];
+  }
+  return I;
+}
+
+static inline idx_t
+mono_rank_sp(const D *d, int n, const idx_t m[n])
+{
+  assert(d && d->R && m);
+  const idx_t *R = d->R;
+  int o = 0, k = d->ko, nmv = d->nmv;
+  for (int i = 1; i < n; i += 2) o += m[i];
+  idx_t I = d->ord2idx[o];
+  // indexes in m should be in ascending order
+  for (int i = n-2; i >= 0; i -= 2) {
+    int v = m[i]-1, knb = v >= nmv;
+    for (int e = 0; e < m[i+1]; ++e)
+      I += R[R_idx(d, v, o-e, knb ? k-e : k)];
+    o -= m[i+1];
+    if (knb) k -= m[i+1];
+  }
+  return I;
+}
+
+static inline void
+mono_unrank(const D *d, int o, idx_t I, ord_t m[])
+{
+  assert(d && d->R && m);
+  const idx_t *R = d->R;
+  int k = d->ko, nmv = d->nmv;
+  I -= d->ord2idx[o];
+  for (int i = d->nv-1; i >= 0; --i) {
+    int knb = i >= nmv, e = 0;
+    idx_t cnt;
+    while (I >= (cnt = R[R_idx(d, i, o-e, knb ? k-e : k)]))
+      I -= cnt, ++e;
+    m[i] = e;
+    o -= e;
+    if (knb) k -= e;
+  }
+  assert(o == 0 && I == 0);
+}
+
 // --- TABLES -----------------------------------------------------------------
 
 static inline void
-tbl_print(int w, int h, ord_t **t)
+tbl_print(const D *d, int h, const idx_t *map_)
 {
+  // print the monomials [0,h), through the index table map_ if any
+  ord_t m[d->nv];
   for (int i = 0; i < MIN(h,50); ++i) {
+    const ord_t *mi = desc_mono(d, map_ ? map_[i] : i, m);
     printf("(%2d) ", i);
-    mad_mono_print(w, t[i]);
-    printf(" o=%d\n", mad_mono_ord(w, t[i]));
+    mad_mono_print(d->nv, mi);
+    printf(" o=%d\n", mad_mono_ord(d->nv, mi));
   }
   if (h > 50) printf("... [ %d more rows ] ...\n", h - 50);
 }
@@ -149,9 +280,9 @@ make_higher_ord_monos(D *d, int curr_mono_idx, int need_realloc, idx_t var_at_id
 }
 
 static inline void
-make_monos(D *d)
+make_monos_search(D *d)
 {
-  // builds the monomials matrix in To order
+  // builds the monomials matrix sorted by ord by search (MAD_DESC_VERIFY)
   assert(d && d->var_ords);
   const int max_init_alloc = 20000;  // to fit (6,12)
   d->nc = max_nc(d->nv, d->mo);
@@ -198,6 +329,82 @@ make_monos(D *d)
   d->size += (d->mo + 2)     * sizeof *(d->ord2idx);
 }
 
+static inline void
+tbl_set_pack(D *d)
+{
+  // var v uses bits(var_ords[v]) bits at pshf[v] in the packed monomials,
+  // pack only if it fits in 64 bits and it is smaller than nv bytes
+  assert(d && d->var_ords);
+  int nv = d->nv, sum = 0, bits[nv];
+  if (nv < desc_pack_nv) return;
+
+  for (int v = 0; v < nv; ++v) {
+    for (bits[v] = 0; d->var_ords[v] >> bits[v]; ++bits[v]) ;
+    sum += bits[v];
+  }
+  if (sum > 64) return;
+
+  d->pshf = mad_malloc(2*nv * sizeof *d->pshf);
+  assert(d->pshf);
+  d->pmsk = d->pshf + nv;
+  d->size += 2*nv * sizeof *d->pshf;
+
+  for (int v = 0, s = 0; v < nv; s += bits[v++]) {
+    d->pshf[v] = bits[v] ? s : 0;   // shift by 64 is undefined
+    d->pmsk[v] = (1u << bits[v]) - 1;
+  }
+}
+
+static inline u64_t
+mono_pack(const D *d, const ord_t m[])
+{
+  u64_t p = 0;
+  for (int v = 0; v < d->nv; ++v)
+    p |= (u64_t)m[v] << d->pshf[v];
+  return p;
+}
+
+static inline void
+make_monos(D *d)
+{
+  // builds the monomials (dense or packed) sorted by ord by unranking, requires R
+  assert(d && d->R);
+  int nv = d->nv, mo = d->mo;
+
+  d->ord2idx = mad_malloc((mo+2) * sizeof *d->ord2idx);
+  assert(d->ord2idx);
+  d->ord2idx[0] = 0;
+  for (int o = 0; o <= mo; ++o)
+    d->ord2idx[o+1] = d->ord2idx[o] + d->R[R_idx(d,nv,o,d->ko)];
+
+  d->nc   = d->ord2idx[mo+1];
+  d->ords = mad_malloc(d->nc * sizeof *d->ords);
+  assert(d->ords);
+
+  if (d->pshf) {
+    d->pmonos = mad_malloc(d->nc * sizeof *d->pmonos);
+    assert(d->pmonos);
+    d->size  += d->nc * sizeof *d->pmonos;
+  } else {
+    d->monos  = mad_malloc(d->nc * nv * sizeof *d->monos);
+    assert(d->monos);
+    d->size  += d->nc * nv * sizeof *d->monos;
+  }
+
+  ord_t m[nv];
+  for (int o = 0; o <= mo; ++o)
+    for (int i = d->ord2idx[o]; i < d->ord2idx[o+1]; ++i) {
+      if (d->pmonos)
+        mono_unrank(d, o, i, m), d->pmonos[i] = mono_pack(d, m);
+      else
+        mono_unrank(d, o, i, d->monos + i*nv);
+      d->ords[i] = o;
+    }
+
+  d->size += d->nc    * sizeof *d->ords;
+  d->size += (mo + 2) * sizeof *d->ord2idx;
+}
+
 static inline int
 find_index(int n, const ord_t **T, const ord_t m[n], int start, int stop)
 {
@@ -215,49 +422,35 @@ find_index(int n, const ord_t **T, const ord_t m[n], int start, int stop)
 enum tbl_ordering {BY_ORD, BY_VAR};
 
 static inline int
-find_index_bin(int n, const ord_t **T, const ord_t m[n], const int from_idx, const int to_idx, enum tbl_ordering tbl_ord)
+find_index_bin(const D *d, const idx_t *map_, const ord_t m[], const int from_idx, const int to_idx, enum tbl_ordering tbl_ord)
 {
-  int start = from_idx, count = to_idx - from_idx, i = 0, step = 0;
+  // search m in the monomials [from_idx,to_idx), through the index table map_ if any
+  int n = d->nv, start = from_idx, count = to_idx - from_idx, i = 0, step = 0;
   int iter = 0;
+  ord_t t[n];
   while (count > 0) {
     ++iter;
     step = count / 2;
     i = start + step;
-    if ((tbl_ord == BY_ORD && mad_mono_ord(n,T[i]) < mad_mono_ord(n,m)) || mad_mono_rcmp(n,T[i],m) < 0) {
+    const ord_t *Ti = desc_mono(d, map_ ? map_[i] : i, t);
+    if ((tbl_ord == BY_ORD && mad_mono_ord(n,Ti) < mad_mono_ord(n,m)) || mad_mono_rcmp(n,Ti,m) < 0) {
       start = ++i;
       count -= step + 1;
     }
     else
       count = step;
   }
-  if ( start < to_idx && mad_mono_equ(n,T[start], m))
+  if ( start < to_idx && mad_mono_equ(n,desc_mono(d, map_ ? map_[start] : start, t), m))
     return start;
 
   // error
-  tbl_print(n, to_idx, (ord_t **)T);
+  tbl_print(d, to_idx, map_);
   printf("monomial not found in table_by_%s: ", tbl_ord == BY_ORD ? "ord" : "var"); mad_mono_print(n,m);
   printf(" Searched from %d to %d\n", from_idx, to_idx);
   assert(NULL);
   return -1;
 }
 
-static inline void
-tbl_by_ord(D *d)
-{
-  assert(d && d->var_ords && d->ord2idx && d->monos);
-
-  d->To    = mad_malloc(d->nc * sizeof *(d->To));
-  assert(d->To);
-  d->size += d->nc * sizeof *(d->To);
-
-  ord_t *monos = d->monos;
-  for (int i = 0; i < d->nc; ++i, monos += d->nv)
-    d->To[i] = monos;
-#ifdef DEBUG
-  tbl_print(d->nv, d->nc, d->To);
-#endif
-}
-
 /**
  Tv depends on To, as it needs to search its monomials there.
  But H matrix wants Tv to be built according to sorted d->var_ords.
@@ -268,12 +461,10 @@ tbl_by_ord(D *d)
 static inline void
 tbl_by_var(D *d)
 {
-  assert(d && d->var_ords && d->sort_var && d->monos && d->ord2idx);
+  assert(d && d->var_ords && d->sort_var && d->ord2idx);
 
-  d->Tv    = mad_malloc(d->nc * sizeof *d->Tv);
   d->tv2to = mad_malloc(d->nc * sizeof *d->tv2to);
   d->to2tv = mad_malloc(d->nc * sizeof *d->to2tv);
-  d->size +=     d->nc * sizeof *d->Tv;
   d->size += 2 * d->nc * sizeof *d->tv2to;  // tv2to + to2tv
 
   int mi = 0, nv = d->nv;
@@ -281,11 +472,9 @@ tbl_by_var(D *d)
   mad_mono_fill(nv, m, 0);
   do {
     int o = mad_mono_ord(nv, m);
-    int idx = find_index_bin(nv, (const ord_t**)d->To, m,
-                             d->ord2idx[o], d->ord2idx[o+1], BY_ORD);
+    int idx = find_index_bin(d, NULL, m, d->ord2idx[o], d->ord2idx[o+1], BY_ORD);
     d->tv2to[mi]  = idx;
     d->to2tv[idx] = mi;
-    d->Tv[mi]     = d->To[idx];
     ++mi;
   } while (mad_desc_mono_nxtbyvar(d,nv,m));
   assert(mi == d->nc);
@@ -295,7 +484,7 @@ tbl_by_var(D *d)
   for (int i = 0; i < d->nv; ++i)
     printf("%d ", d->sort_var[i]);
   printf("\n");
-  tbl_print(nv, d->nc, d->Tv);
+  tbl_print(d, d->nc, d->tv2to);
   printf("tv2to=[ ");
   for (int i = 0; i < MIN(d->nc,50); ++i) printf("%d ", d->tv2to[i]);
   printf("%s]\n", d->nc > 50 ? " ... " : "");
@@ -383,7 +572,7 @@ tbl_solve_H(D *d)
       nxt_mono_by_unk(nv,vo,sort,r,o,mono);  // ATTENTION: it's r, not v
       if (mad_desc_mono_isvalid(d,nv,mono)) {
         idx_t idx0 = tbl_index_H(d,nv,mono);
-        idx_t idx1 = find_index_bin(nv,(const ord_t**)d->Tv,mono,idx0,d->nc,BY_VAR);
+        idx_t idx1 = find_index_bin(d,d->tv2to,mono,idx0,d->nc,BY_VAR);
         d->H[r*cols + o] = idx1 - idx0;
       }
       else
@@ -397,8 +586,8 @@ tbl_build_H(D *d)
 {
   idx_t *H = d->H;
   int rows = d->nv, cols = d->mo + 2, nc = d->nc;
-  ord_t *var_ords = d->var_ords, **Tv = d->Tv;
-  idx_t *sort = d->sort_var;
+  ord_t *var_ords = d->var_ords;
+  idx_t *sort = d->sort_var, *tv2to = d->tv2to;
 
   // minimal constants for 1st row
   for (int c = 0; c < cols; ++c)
@@ -412,10 +601,11 @@ tbl_build_H(D *d)
 
     // initial congruence from Tv
     for (int m = 1; m < nc; m++) { // monomials
-      if (Tv[m][var_idx] != Tv[m-1][var_idx]) {
+      ord_t e = desc_mono_var(d, tv2to[m], var_idx);
+      if (e != desc_mono_var(d, tv2to[m-1], var_idx)) {
         H[r*cols + curr_col] = m;
         curr_col++;
-        if (Tv[m][var_idx] == 0) break;
+        if (e == 0) break;
       }
     }
 
@@ -432,7 +622,7 @@ tbl_build_H(D *d)
 static inline void
 tbl_set_H(D *d)
 {
-  assert(d && d->var_ords && d->Tv && d->To);
+  assert(d && d->var_ords && d->tv2to);
   assert(d->nv != 0);
 
   d->H = mad_malloc(d->nv * (d->mo+2) * sizeof *(d->H));
@@ -485,35 +675,35 @@ tbl_build_LC(int oa, int ob, D *d)
 #ifdef DEBUG
   // printf("tbl_set_LC oa=%d ob=%d\n", oa, ob);
 #endif
-  assert(d && d->To && d->ord2idx && d->tv2to);
+  assert(d && d->ord2idx && d->R);
   assert(oa < d->mo && ob < d->mo);
 
-  ord_t **To = d->To;
-  const int *pi   = d->ord2idx,  *tv2to = d->tv2to,          // shorter names
+  const int *pi   = d->ord2idx,                                   // shorter names
              iao  = pi[oa],            ibo   = pi[ob],            // offsets
              cols = pi[oa+1] - pi[oa], rows  = pi[ob+1] - pi[ob]; // sizes
 
   int mat_size = rows * cols;
   idx_t *lc = mad_malloc(mat_size * sizeof *lc);
   assert(lc);
-  d->size += mat_size * sizeof *lc;
   for (int i = 0; i < mat_size; ++i)
     lc[i] = -1;
 
-  ord_t m[d->nv];
+  ord_t m[d->nv], ma[d->nv], mb[d->nv];
   int ic, idx_lc;
   for (int ib = pi[ob]; ib < pi[ob+1]; ++ib) {
+    const ord_t *Tb = desc_mono(d, ib, mb);
     int lim_a = oa == ob ? ib+1 : pi[oa+1];   // triangular is lower left
     for (int ia = pi[oa]; ia < lim_a; ++ia) {
-      mad_mono_add(d->nv, To[ia], To[ib], m);
+      const ord_t *Ta = desc_mono(d, ia, ma);
+      mad_mono_add(d->nv, Ta, Tb, m);
       if (mad_desc_mono_isvalid(d,d->nv,m)) {
-        ic = tv2to[tbl_index_H(d,d->nv,m)];
+        ic = mono_rank(d,d->nv,m);
         idx_lc = hpoly_idx(ib-ibo, ia-iao, cols);
         lc[idx_lc] = ic;
 #ifdef DEBUG
         /*
-        printf(" ib=%d ", ib); mad_mono_print(d->nv, To[ib]);
-        printf(" ia=%d ", ia); mad_mono_print(d->nv, To[ia]);
+        printf(" ib=%d ", ib); mad_mono_print(d->nv, Tb);
+        printf(" ia=%d ", ia); mad_mono_print(d->nv, Ta);
         printf(" ic=%d ", ic); mad_mono_print(d->nv, m);
         printf(" ilc=%d\n", idx_lc);
         */
@@ -536,11 +726,9 @@ get_LC_idxs(int oa, int ob, D *d)
 
   int **LC_idx = mad_malloc(3 * sizeof *LC_idx);
   assert(LC_idx);
-  d->size += 3 * sizeof *LC_idx;
 
   int *limits = mad_malloc(3 * rows * sizeof *limits); // rows: [start split end]
   assert(limits);
-  d->size += 3 * rows * sizeof *limits;
 
   const int START = 0, SPLIT = 1, END = 2;
 
@@ -578,6 +766,20 @@ get_LC_idxs(int oa, int ob, D *d)
   return LC_idx;
 }
 
+static inline int
+tbl_pairs_L(const D *d, int pairs[])
+{
+  // (oa,ob) pairs of L by decreasing oc (i.e. cost), for load balancing
+  int np = 0;
+  for (int oc = d->mo; oc >= 2; --oc)
+    for (int j = 1; j <= oc / 2; ++j) {
+      pairs[2*np  ] = oc - j;
+      pairs[2*np+1] = j;
+      ++np;
+    }
+  return np;
+}
+
 static inline void
 tbl_set_L(D *d)
 {
@@ -594,63 +796,151 @@ tbl_set_L(D *d)
 
   memset(d->L,     0, size_L);
   memset(d->L_idx, 0, size_lci);
-  // #ifdef _OPENMP
-  // #pragma omp parallel for schedule(guided,1)
-  // #endif
-  for (int oc = 2; oc <= d->mo; ++oc)
-    for (int j = 1; j <= oc / 2; ++j) {
-      int oa = oc - j, ob = j;
 
-      d->L    [oa*ho + ob] = tbl_build_LC(oa, ob, d);
-      d->L_idx[oa*ho + ob] = get_LC_idxs (oa, ob, d);
-    }
+  // each (oa,ob) writes only its own L and L_idx slots: output is deterministic
+  int pairs[2*(o*ho + 1)];
+  int np = tbl_pairs_L(d, pairs);
+
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1) if (d->nc >= desc_par_nc)
+  #endif
+  for (int p = 0; p < np; ++p) {
+    int oa = pairs[2*p], ob = pairs[2*p+1];
+    d->L    [oa*ho + ob] = tbl_build_LC(oa, ob, d);
+    d->L_idx[oa*ho + ob] = get_LC_idxs (oa, ob, d);
+  }
+
+  for (int p = 0; p < np; ++p) {
+    int oa = pairs[2*p], ob = pairs[2*p+1], *pi = d->ord2idx;
+    int cols = pi[oa+1] - pi[oa], rows = pi[ob+1] - pi[ob];
+    d->size += rows * cols * sizeof **d->L;
+    d->size += 3 * sizeof *d->L_idx[0] + 3 * rows * sizeof **d->L_idx[0];
+  }
 
 #ifdef DEBUG
   tbl_print_L(d);
 #endif
 }
 
+// --- K knobs splitting ------------------------------------------------------
+
+static inline void
+tbl_set_K(D *d)
+{
+  // for each mono i containing only map vars, K[i]..K[i+1] gives the
+  // range of pairs in K_idx of its knob children: [coef idx, knob-only idx]
+  assert(d && d->ord2idx && d->R);
+  if (d->nmv == d->nv) return;  // no knobs
+
+  int nc = d->nc, nv = d->nv, nmv = d->nmv;
+  d->K     = mad_malloc((nc+1) * sizeof *d->K);
+  d->K_idx = mad_malloc(  2*nc * sizeof *d->K_idx);
+  assert(d->K && d->K_idx);
+  d->size += (nc+1) * sizeof *d->K;
+  d->size +=   2*nc * sizeof *d->K_idx;
+
+  idx_t *K = d->K;
+  ord_t m[nv];
+  mad_alloc_tmp(idx_t, pure, nc);
+  mad_alloc_tmp(idx_t, pos , nc);
+
+  // count children of each pure mono
+  memset(K, 0, (nc+1) * sizeof *K);
+  for (int i = 0; i < nc; ++i) {
+    mad_mono_copy(nv, desc_mono(d,i,m), m);
+    mad_mono_fill(nv-nmv, m+nmv, 0);  // keep only the map vars
+    pure[i] = mono_rank(d,nv,m);
+    ++K[pure[i]+1];
+  }
+  for (int i = 0; i < nc; ++i)
+    K[i+1] += K[i];
+
+  // fill pairs, children are stored by increasing order
+  memcpy(pos, K, nc * sizeof *pos);
+  for (int i = 0; i < nc; ++i) {
+    mad_mono_copy(nv, desc_mono(d,i,m), m);
+    mad_mono_fill(nmv, m, 0);         // keep only the knobs
+    idx_t j = pos[pure[i]]++;
+    d->K_idx[2*j  ] = i;
+    d->K_idx[2*j+1] = mono_rank(d,nv,m);
+  }
+  mad_free_tmp(pos);
+  mad_free_tmp(pure);
+}
+
 // --- TABLE TEST --------------------------------------------------------------
 
+static inline int
+tbl_check_LC(D *d, int oa, int ob)
+{
+  int ho = d->mo / 2, oc = oa + ob, *pi = d->ord2idx;
+  ord_t m[d->nv], ma[d->nv], mb[d->nv];
+  idx_t *lc = d->L[oa*ho + ob];
+  if (!lc)                                   return  1e7 + oa*1e3 + ob;
+
+  int sa = pi[oa+1]-pi[oa], sb = pi[ob+1]-pi[ob];
+
+  for (int ibl = 0; ibl < sb; ++ibl) {
+    int lim_a = oa == ob ? ibl+1 : sa;
+    for (int ial = 0; ial < lim_a; ++ial) {
+      int ib = ibl + pi[ob], ia = ial + pi[oa];
+      int il = hpoly_idx(ibl,ial,sa);
+      if (il < 0)                              return -2e7 - ia*1e5 - ib;
+      if (il >= sa * sb)                       return  2e7 + ia*1e5 + ib;
+
+      int ic = lc[il];
+      if (ic >= pi[oc+1])                      return  3e7 + ic*1e5 + 11;
+      if (ic >= 0 && ic < d->ord2idx[oc]) return  3e7 + ic*1e5 + 12;
+
+      mad_mono_add(d->nv, desc_mono(d,ia,ma), desc_mono(d,ib,mb), m);
+      if (ic < 0 && mad_desc_mono_isvalid(d,d->nv,m))
+                                               return -3e7          - 13;
+    }
+  }
+  return 0;
+}
+
 static inline int
 tbl_check_L(D *d)
 {
-  assert(d && d->ord2idx && d->L && d->var_ords && d->To && d->H);
-  int ho = d->mo / 2, *pi = d->ord2idx;
-  ord_t m[d->nv];
-  for (int oc = 2; oc <= d->mo; ++oc)
-    for (int j = 1; j <= oc / 2; ++j) {
-      int oa = oc - j, ob = j;
-      idx_t *lc = d->L[oa*ho + ob];
-      if (!lc)                                   return  1e7 + oa*1e3 + ob;
-
-      int sa = pi[oa+1]-pi[oa], sb = pi[ob+1]-pi[ob];
-
-      for (int ibl = 0; ibl < sb; ++ibl) {
-        int lim_a = oa == ob ? ibl+1 : sa;
-        for (int ial = 0; ial < lim_a; ++ial) {
-          int ib = ibl + pi[ob], ia = ial + pi[oa];
-          int il = hpoly_idx(ibl,ial,sa);
-          if (il < 0)                              return -2e7 - ia*1e5 - ib;
-          if (il >= sa * sb)                       return  2e7 + ia*1e5 + ib;
-
-          int ic = lc[il];
-          if (ic >= pi[oc+1])                      return  3e7 + ic*1e5 + 11;
-          if (ic >= 0 && ic < d->ord2idx[oc]) return  3e7 + ic*1e5 + 12;
-
-          mad_mono_add(d->nv, d->To[ia], d->To[ib], m);
-          if (ic < 0 && mad_desc_mono_isvalid(d,d->nv,m))
-                                                   return -3e7          - 13;
-        }
-      }
+  assert(d && d->ord2idx && d->L && d->var_ords && d->R);
+  int ho = d->mo / 2;
+  int pairs[2*(d->mo*ho + 1)], errs[d->mo*ho + 1];
+  int np = tbl_pairs_L(d, pairs);
+
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1) if (d->nc >= desc_par_nc)
+  #endif
+  for (int p = 0; p < np; ++p)
+    errs[p] = tbl_check_LC(d, pairs[2*p], pairs[2*p+1]);
+
+  // report the first error in pairs order, whatever the threads
+  for (int p = 0; p < np; ++p)
+    if (errs[p]) return errs[p];
+  return 0;
+}
+
+static inline int
+tbl_check_K(D *d)
+{
+  if (!d->K) return 0;
+  ord_t m[d->nv], mi[d->nv], mk[d->nv];
+  for (int i = 0; i < d->nc; ++i) {
+    if (d->K[i] > d->K[i+1])                     return 8e6 + i;
+    for (int j = d->K[i]; j < d->K[i+1]; ++j) {
+      mad_mono_add(d->nv, desc_mono(d,i,mi), desc_mono(d,d->K_idx[2*j+1],mk), m);
+      if (! mad_mono_equ(d->nv, m, desc_mono(d,d->K_idx[2*j],mk)))
+                                                 return 9e6 + i;
     }
+  }
   return 0;
 }
 
-static inline int  // error code
-tbl_check(D *d)
+static inline int
+tbl_check_search(D *d)
 {
-  ord_t **Tv = d->Tv, **To = d->To, *monos = d->monos, *vo = d->var_ords;
+#if MAD_DESC_VERIFY
+  ord_t *vo = d->var_ords, mi[d->nv], mv[d->nv];
   const idx_t *tv2to = d->tv2to, *to2tv = d->to2tv, *H = d->H, *sort = d->sort_var,
                   nv = d->nv, cols = d->mo + 2;
 
@@ -669,11 +959,47 @@ tbl_check(D *d)
 
   for (int i = 0; i < d->nc; ++i) {
     if (to2tv[tv2to[i]] != i)                  return 4e6 + i;
-    if (tv2to[tbl_index_H(d,nv,To[i])] != i)   return 5e6 + i;
-    if (! mad_mono_equ(nv,To[tv2to[i]],Tv[i])) return 6e6 + i;
-    if (! mad_mono_equ(nv,To[i],monos + nv*i)) return 7e6 + i;
+    if (tv2to[tbl_index_H(d,nv,desc_mono(d,i,mi))] != i)
+                                               return 5e6 + i;
+    if (tbl_index_H(d,nv,desc_mono(d,tv2to[i],mv)) != i)
+                                               return 6e6 + i;
+  }
+
+  // check monomials built by search
+  D s = *d;
+  s.monos = NULL, s.ords = NULL, s.ord2idx = NULL, s.pmonos = NULL;
+  make_monos_search(&s);
+  int err = s.nc != d->nc;
+  for (int o = 0; !err && o <= d->mo+1; ++o)
+    err = s.ord2idx[o] != d->ord2idx[o];
+  for (int i = 0; !err && i < d->nc; ++i)
+    err = !mad_mono_equ(nv, s.monos + nv*i, desc_mono(d,i,mi));
+  mad_free(s.monos);
+  mad_free(s.ords);
+  mad_free(s.ord2idx);
+  if (err)                                     return 1e8;
+#else
+  (void)d;
+#endif
+  return 0;
+}
+
+static inline int  // error code
+tbl_check(D *d)
+{
+  const idx_t nv = d->nv;
+  ord_t m[nv], u[nv];
+
+  for (int i = 0; i < d->nc; ++i) {
+    const ord_t *mi = desc_mono(d,i,m);
+    if (mono_rank(d,nv,mi) != i)               return 5e6 + i;
+    if (mad_mono_ord(nv,mi) != d->ords[i])     return 7e6 + i;
+    mono_unrank(d,d->ords[i],i,u);
+    if (! mad_mono_equ(nv,mi,u))               return 7e6 + i;
   }
-  return tbl_check_L(d);
+  int err = tbl_check_search(d);
+  if (!err) err = tbl_check_L(d);
+  return err ? err : tbl_check_K(d);
 }
 
 // --- THREAD DISPATCH ---------------------------------------------------------
@@ -728,7 +1054,7 @@ build_dispatch(D *d)
     sizes[t] = 0;
   }
 
-  long long int ops[d->mo+1], dops[nb_threads];
+  long long int ops[d->mo+2], dops[nb_threads];  // ops[mo+1] used for mo >= 12
   memset(dops, 0, nb_threads * sizeof *dops);
   get_ops(d,ops);
 
@@ -759,11 +1085,212 @@ build_dispatch(D *d)
 #endif
 }
 
-// --- DESC management ---------------------------------------------------------
+// --- NUMA PLACEMENT ----------------------------------------------------------
+
+/**
+ The tables are first touched by the thread building the descriptor, hence
+ they are all on its node. If mad_desc_numa is not zero, the pages of the
+ tables are moved once built with mbind(MPOL_MF_MOVE) (Linux and OpenMP only,
+ no libnuma), i.e. only whole pages are moved:
+ - desc_numa_pin pins the OpenMP worker threads to the cpus allowed for the
+   process (once, unless the OpenMP runtime already binds them, e.g.
+   OMP_PROC_BIND). The calling thread is not pinned and keeps its affinity.
+ - desc_numa_local moves the L tables of the orders dispatched to each thread
+   of hpoly_mul_par (mo >= 12) to the node of that thread.
+ - desc_numa_ilv interleaves the other shared tables (monomials, R, K and the
+   L tables not moved locally) over the nodes.
+ The temporaries of compose_par are allocated by the workers in their pool.
+ The memory policies are reset to the default by mad_desc_del before the
+ tables are freed (or when a placement fails), so the pages reused by the
+ allocator do not inherit them.
+ */
+
+#if DESC_NUMA
+
+static inline int
+numa_node (void)
+{
+  unsigned cpu, node;
+  return syscall(SYS_getcpu, &cpu, &node, NULL) ? -1 : (int)node;
+}
+
+static inline int // error
+numa_move (const void *ptr, size_t size, int mode, int node)
+{
+  uintptr_t psz = sysconf(_SC_PAGESIZE),
+            beg = ((uintptr_t)ptr + psz-1) & ~(psz-1),
+            end = ((uintptr_t)ptr + size ) & ~(psz-1);
+  if (!ptr || end <= beg) return 0;  // less than a page
+
+  if (mode == MPOL_DEFAULT)
+    return syscall(SYS_mbind, beg, end-beg, MPOL_DEFAULT, NULL, 0, 0) != 0;
+
+  unsigned long mask = mode == MPOL_INTERLEAVE ? ~0ul : 1ul << node;
+  if (mode != MPOL_INTERLEAVE && (node < 0 || node >= (int)(CHAR_BIT*sizeof mask)))
+    return 1;
+  return syscall(SYS_mbind, beg, end-beg, mode, &mask, CHAR_BIT*sizeof mask+1,
+                 MPOL_MF_MOVE) != 0;
+}
+
+static inline int // error
+numa_pin (void)
+{
+  static int pinned = 0;
+  if (pinned || omp_get_proc_bind() != omp_proc_bind_false) return 0;
+
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof set, &set)) return 1;
+
+  int ncpu = 0, cpus[CPU_SETSIZE], err = 0;
+  for (int c = 0; c < CPU_SETSIZE; ++c)
+    if (CPU_ISSET(c, &set)) cpus[ncpu++] = c;
+
+  // thread 0 is the caller, leave it unpinned
+  #pragma omp parallel num_threads(omp_get_num_procs()) reduction(+:err)
+  if (omp_get_thread_num()) {
+    cpu_set_t one;
+    CPU_ZERO(&one);
+    CPU_SET(cpus[omp_get_thread_num() % ncpu], &one);
+    err += sched_setaffinity(0, sizeof one, &one) != 0;
+  }
+  pinned = !err;
+  return err;
+}
+
+static inline size_t
+numa_size_L (const D *d, int oa, int ob)
+{
+  const idx_t *pi = d->ord2idx;
+  return (size_t)(pi[oa+1]-pi[oa]) * (pi[ob+1]-pi[ob]) * sizeof **d->L;
+}
+
+static inline size_t
+numa_size_Li (const D *d, int ob)
+{
+  const idx_t *pi = d->ord2idx;
+  return 3 * (size_t)(pi[ob+1]-pi[ob]) * sizeof **d->L_idx[0];
+}
+
+static inline int // error
+numa_local (D *d, char placed[])
+{
+  // same loop as hpoly_mul_par to get the same thread for each t
+  int nb_threads = omp_get_num_procs(), ho = d->mo/2, err = 0;
+
+  #pragma omp parallel for reduction(+:err)
+  for (int t = 0; t < nb_threads; ++t) {
+    int node = numa_node();
+    for (int i = 0; d->ocs[t][i]; ++i) {
+      int oc = d->ocs[t][i];
+      if (oc > d->mo) continue;  // second half of mo, see build_dispatch
+      for (int ob = 1; ob <= oc/2; ++ob) {
+        int oa = oc-ob, p = oa*ho + ob;
+        err += numa_move( d->L    [p], numa_size_L (d,oa,ob), MPOL_PREFERRED, node);
+        err += numa_move(*d->L_idx[p], numa_size_Li(d,   ob), MPOL_PREFERRED, node);
+        placed[p] = 1;
+      }
+    }
+  }
+  return err;
+}
+
+static inline int // error
+numa_ilv (D *d, const char placed[])
+{
+  int nc = d->nc, nv = d->nv, ho = d->mo/2, err = 0;
+  size_t nr = (size_t)(nv+1)*(d->mo+1)*(d->ko+1);
 
-enum { TPSA_DESC_NUM = 100 };    // number of descriptors to store
+  err += numa_move(d->monos , nc*nv * sizeof *d->monos , MPOL_INTERLEAVE, 0);
+  err += numa_move(d->pmonos, nc    * sizeof *d->pmonos, MPOL_INTERLEAVE, 0);
+  err += numa_move(d->ords  , nc    * sizeof *d->ords  , MPOL_INTERLEAVE, 0);
+  err += numa_move(d->R     , nr    * sizeof *d->R     , MPOL_INTERLEAVE, 0);
+  err += numa_move(d->K     , (nc+1)* sizeof *d->K     , MPOL_INTERLEAVE, 0);
+  err += numa_move(d->K_idx , 2*nc  * sizeof *d->K_idx , MPOL_INTERLEAVE, 0);
+
+  for (int oc = 2; oc <= d->mo; ++oc)
+    for (int ob = 1; ob <= oc/2; ++ob) {
+      int oa = oc-ob, p = oa*ho + ob;
+      if (placed[p]) continue;
+      err += numa_move( d->L    [p], numa_size_L (d,oa,ob), MPOL_INTERLEAVE, 0);
+      err += numa_move(*d->L_idx[p], numa_size_Li(d,   ob), MPOL_INTERLEAVE, 0);
+    }
+  return err;
+}
+
+static inline int // error
+numa_reset (D *d)
+{
+  int nc = d->nc, nv = d->nv, ho = d->mo/2, err = 0;
+  size_t nr = (size_t)(nv+1)*(d->mo+1)*(d->ko+1);
+
+  err += numa_move(d->monos , nc*nv * sizeof *d->monos , MPOL_DEFAULT, 0);
+  err += numa_move(d->pmonos, nc    * sizeof *d->pmonos, MPOL_DEFAULT, 0);
+  err += numa_move(d->ords  , nc    * sizeof *d->ords  , MPOL_DEFAULT, 0);
+  err += numa_move(d->R     , nr    * sizeof *d->R     , MPOL_DEFAULT, 0);
+  err += numa_move(d->K     , (nc+1)* sizeof *d->K     , MPOL_DEFAULT, 0);
+  err += numa_move(d->K_idx , 2*nc  * sizeof *d->K_idx , MPOL_DEFAULT, 0);
+
+  if (d->L)
+    for (int oc = 2; oc <= d->mo; ++oc)
+      for (int ob = 1; ob <= oc/2; ++ob) {
+        int oa = oc-ob, p = oa*ho + ob;
+        err += numa_move( d->L    [p], numa_size_L (d,oa,ob), MPOL_DEFAULT, 0);
+        if (d->L_idx[p])
+          err += numa_move(*d->L_idx[p], numa_size_Li(d,ob), MPOL_DEFAULT, 0);
+      }
+  return err;
+}
+
+#endif // DESC_NUMA
+
+static inline void
+numa_place (D *d)
+{
+  // set d->numa to the policies applied without error
+  int pol = mad_desc_numa, numa = 0;
+  if (!pol) return;
+
+#if DESC_NUMA
+  int ho = d->mo/2;
+  char placed[d->mo*ho + 1];
+  memset(placed, 0, sizeof placed);
+
+  if ((pol & desc_numa_pin) && !numa_pin())
+    numa |= desc_numa_pin;
+  if ((pol & desc_numa_local) && omp_get_num_procs() > 1 && d->mo >= 12
+      && !numa_local(d, placed))
+    numa |= desc_numa_local;
+  if ((pol & desc_numa_ilv) && !numa_ilv(d, placed))
+    numa |= desc_numa_ilv;
+
+  // a failed placement may have moved some tables, reset them all
+  if ((pol & (desc_numa_local|desc_numa_ilv)) !=
+     (numa & (desc_numa_local|desc_numa_ilv))) {
+    numa_reset(d);
+    numa &= ~(desc_numa_local|desc_numa_ilv);
+  }
+#endif
+
+  if (numa != pol)
+    trace(1, "NUMA placement %d requested, %d applied", pol, numa);
+  d->numa = numa;
+}
+
+static inline void
+numa_unplace (D *d)
+{
+  // restore the default memory policy of the tables before freeing them
+#if DESC_NUMA
+  if ((d->numa & (desc_numa_local|desc_numa_ilv)) && numa_reset(d))
+    trace(1, "NUMA placement %d not reset", d->numa);
+#endif
+  d->numa = 0;
+}
+
+// --- DESC management ---------------------------------------------------------
 
 static D  *Ds[TPSA_DESC_NUM];
+static unsigned Dgen[TPSA_DESC_NUM]; // generation of each id, see desc_tcur
 
 static inline void
 set_var_ords(D *d, const ord_t ords[])
@@ -840,21 +1367,28 @@ desc_build(int nmv, const ord_t map_ords[nmv], str_t var_nam_[nmv], int nv, cons
 {
   assert(map_ords && ords);
 
+  num_t t0 = omp_get_wtime();
   D *d = desc_init(nmv,map_ords, nv, ko);
 
   set_var_ords(d, ords);
   set_var_names(d, var_nam_);
-  make_monos(d);
-  tbl_by_ord(d);
-  tbl_by_var(d);  // requires To
+  tbl_set_R(d);
+  tbl_set_pack(d);
+  make_monos(d);  // requires R
+#if MAD_DESC_VERIFY
+  tbl_by_var(d);  // requires monos
   tbl_set_H(d);
+#endif
   tbl_set_L(d);
+  tbl_set_K(d);
   build_dispatch(d);
+  numa_place(d);
 
   // set temps
   for(int i=0; i < desc_max_temps; i++) {
     d-> t[i] = mad_tpsa_newd (d,d->mo);
     d->ct[i] = mad_ctpsa_newd(d,d->mo);
+    d->ft[i] = mad_ftpsa_newd(d,d->mo);
   }
 
   // TODO: add the size of the temps to d->size
@@ -866,13 +1400,17 @@ desc_build(int nmv, const ord_t map_ords[nmv], str_t var_nam_[nmv], int nv, cons
   int err = tbl_check(d);
   if (err != 0) {
     printf("\nA= ");   mad_mono_print(d->nv, d->var_ords);
+#if MAD_DESC_VERIFY
     printf("\nH=\n");  tbl_print_H(d);
-    printf("\nTv=\n"); tbl_print(d->nv, d->nc, d->Tv);
-    printf("\nTo=\n"); tbl_print(d->nv, d->nc, d->To);
+    printf("\nTv=\n"); tbl_print(d, d->nc, d->tv2to);
+#endif
+    printf("\nTo=\n"); tbl_print(d, d->nc, NULL);
     printf("\nCheking table consistency ... %d\n", err);
     assert(NULL);
   }
 
+  d->time = omp_get_wtime() - t0;
+  d->nthr = d->nc >= desc_par_nc ? omp_get_max_threads() : 1;
   return d;
 }
 
@@ -918,6 +1456,7 @@ get_desc(int nmv, const ord_t map_ords[nmv], str_t var_nam_[nmv], int nv, const
     if (!Ds[i]) {
       Ds[i] = desc_build(nmv,map_ords,var_nam_, nv,ords, ko);
       Ds[i]->id = i;
+      Ds[i]->gen = ++Dgen[i];
       return Ds[i];
     }
   ensure(NULL && "Too many descriptors.");
@@ -931,7 +1470,10 @@ mad_desc_get_mono (const D *d, int n, ord_t m_[n], idx_t i)
   assert(d);
   ensure(0 <= n && n < d->nv);
   ensure(0 <= i && i < d->nc);
-  if (m_ && n) memcpy(m_, d->To[i], n * sizeof(ord_t));
+  if (m_ && n) {
+    ord_t m[d->nv];
+    memcpy(m_, desc_mono(d,i,m), n * sizeof(ord_t));
+  }
   return d->ords[i];
 }
 
@@ -940,7 +1482,7 @@ mad_desc_get_idx (const D *d, int n, const ord_t m[n])
 {
   assert(d && m);
   ensure(mad_desc_mono_isvalid(d, n, m));
-  return d->tv2to[tbl_index_H(d,n,m)];
+  return mono_rank(d,n,m);
 }
 
 idx_t
@@ -948,7 +1490,7 @@ mad_desc_get_idx_sp (const D *d, int n, const idx_t m[n])
 {
   assert(d && m);
   ensure(mad_desc_mono_isvalid_sp(d, n, m));
-  return d->tv2to[tbl_index_H_sp(d,n,m)];
+  return mono_rank_sp(d,n,m);
 }
 
 int
@@ -1026,6 +1568,57 @@ mad_desc_gtrunc(D *d, ord_t to)
   return orig;
 }
 
+num_t
+mad_desc_geps(D *d, num_t eps)
+{
+  assert(d);
+  num_t orig = d->eps;
+  if (eps >= 0) d->eps = eps;
+  return orig;
+}
+
+void
+mad_desc_pstat(const D *d, prune_stat_t *stat)
+{
+  assert(d && stat);
+  *stat = d->pstat;
+}
+
+void
+mad_desc_pstat_reset(D *d)
+{
+  assert(d);
+  d->pstat = (prune_stat_t){ 0 };
+}
+
+ord_t
+mad_desc_ttrunc(D *d, ord_t to)
+{
+  assert(d);
+  ord_t orig = desc_trunc(d);
+  if (to == mad_tpsa_same)
+    return orig;
+
+  if (to == mad_tpsa_default)
+    desc_tctx(d, 0);
+  else {
+    ensure(to <= d->mo);
+    desc_tctx(d, to+1);
+  }
+  return orig;
+}
+
+void
+mad_desc_info(const D *d, FILE *stream_)
+{
+  assert(d);
+  if (!stream_) stream_ = stdout;
+  fprintf(stream_, "desc %d: nmv=%d, nv=%d, mo=%d, ko=%d, nc=%d, size=%zu bytes, "
+                   "build=%.3f s (%d threads), numa=%d, eps=%g\n", d->id, d->nmv, d->nv, d->mo,
+                   d->ko, d->nc, d->size, d->time, d->nthr,
+                   d->numa, d->eps);
+}
+
 D*
 mad_desc_new(int nv, const ord_t var_ords[nv], const ord_t map_ords_[nv], str_t var_nam_[nv])
 {
@@ -1084,16 +1677,20 @@ void
 mad_desc_del(D *d)
 {
   assert(d);
+  numa_unplace(d);
   mad_free(d->var_ords);
   mad_free(d->map_ords);
   mad_free(d->monos);
+  mad_free(d->pmonos);
+  mad_free(d->pshf);  // pmsk in the same block
   mad_free(d->ords);
-  mad_free(d->To);
-  mad_free(d->Tv);
   mad_free(d->ord2idx);
+  mad_free(d->R);
   mad_free(d->tv2to);
   mad_free(d->to2tv);
   mad_free(d->H);
+  mad_free(d->K);
+  mad_free(d->K_idx);
 
   if (d->var_names_) {
     for (int i = 0; i < d->nmv; ++i)
@@ -1102,7 +1699,7 @@ mad_desc_del(D *d)
   }
 
   if (d->L) {  // if L exists, then L_idx exists too
-    for (int i = 0; i < 1 + d->mo * d->mo/2; ++i) {
+    for (int i = 0; i < 1 + d->mo * (d->mo/2); ++i) {
       mad_free(d->L[i]);
       if (d->L_idx[i]) {
         mad_free(*d->L_idx[i]);  // allocated as single block
@@ -1123,9 +1720,11 @@ mad_desc_del(D *d)
   for(int i=0; i < desc_max_temps; i++) {
     mad_tpsa_del (d-> t[i]);
     mad_ctpsa_del(d->ct[i]);
+    mad_ftpsa_del(d->ft[i]);
   }
 
-  // remove descriptor from global array
+  // remove descriptor from global array, the truncation contexts of the
+  // threads expire with its generation
   Ds[d->id] = NULL;
   mad_free(d);
 }
@@ -24,6 +24,31 @@
 
   Information:
   - parameters ending with an underscope can be null.
+  - mad_desc_numa sets the NUMA placement of the tables of the descriptors
+    built afterward (Linux and OpenMP only), as a combination of:
+    desc_numa_pin pins the OpenMP workers to the allowed cpus (once, the
+    calling thread is not pinned),
+    desc_numa_local moves the multiplication tables used by each thread of
+    the parallel mul (mo >= 12) to its node (threads should be pinned),
+    desc_numa_ilv interleaves the other tables over the nodes.
+    mad_desc_info reports the placement applied.
+  - mad_desc_gtrunc sets the truncation order of the operations for all the
+    threads, mad_desc_ttrunc overrides it for the calling thread only, e.g.
+    to run low order computations in parallel with high order ones on the
+    same descriptor. Both return the previous order (global for gtrunc,
+    seen by the calling thread for ttrunc), mad_tpsa_same only queries it
+    and mad_tpsa_default resets it (to mo for gtrunc, to the global order
+    for ttrunc).
+  - the parallel operations (e.g. compose) run with the truncation of the
+    calling thread. The thread truncations of a deleted descriptor are
+    discarded in all the threads, a new descriptor starts without any.
+  - mad_desc_geps sets the pruning threshold of the descriptor (0: none,
+    default), the coefficients with |c| < eps of the results of mul and
+    compose are zeroed and their orders dropped if they become empty (see
+    mad_tpsa_prune), e.g. to keep nearly linear maps cheap over long chains
+    of operations. It returns the previous threshold, eps < 0 only queries
+    it. mad_desc_pstat gets the number of prunes, zeroed coefficients and
+    dropped orders (all threads) since the last mad_desc_pstat_reset.
 
   Errors:
   - TODO
@@ -31,18 +56,30 @@
  o----------------------------------------------------------------------------o
  */
 
+#include <stdio.h>
+
 #include "mad_defs.h"
 #include "mad_mono.h"
 
 // --- types -----------------------------------------------------------------o
 
 typedef struct desc desc_t;
+typedef struct prune_stat prune_stat_t;
+
+enum desc_numa {
+  desc_numa_pin = 1, desc_numa_local = 2, desc_numa_ilv = 4
+};
+
+struct prune_stat {
+  u64_t calls, coefs, ords;
+};
 
 // --- globals ---------------------------------------------------------------o
 
 extern const ord_t mad_tpsa_default;
 extern const ord_t mad_tpsa_same;
 extern       int   mad_tpsa_strict;
+extern       int   mad_desc_numa;
 
 // --- interface -------------------------------------------------------------o
 
@@ -55,7 +92,14 @@ void    mad_desc_del  (desc_t *d);
 // introspection
 int     mad_desc_maxsize (const desc_t *d);
 ord_t   mad_desc_maxord  (const desc_t *d);
-ord_t   mad_desc_gtrunc  (      desc_t *d, ord_t to);
+ord_t   mad_desc_gtrunc  (      desc_t *d, ord_t to); // all threads
+ord_t   mad_desc_ttrunc  (      desc_t *d, ord_t to); // calling thread
+void    mad_desc_info    (const desc_t *d, FILE *stream_);
+
+// pruning
+num_t   mad_desc_geps    (      desc_t *d, num_t eps); // eps < 0: query only
+void    mad_desc_pstat   (const desc_t *d, prune_stat_t *stat);
+void    mad_desc_pstat_reset (desc_t *d);
 
 // ---------------------------------------------------------------------------o
 
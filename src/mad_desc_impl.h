@@ -24,6 +24,7 @@
 #include "mad_desc.h"
 #include "mad_tpsa.h"
 #include "mad_ctpsa.h"
+#include "mad_ftpsa.h"
 
 // --- types -----------------------------------------------------------------o
 
@@ -37,28 +38,54 @@ struct desc {
   char*   *var_names_; // names of map variables; TODO: move it 1 level above and set indirection
 
   size_t   size;       // bytes used by current desc
+  num_t    time;       // seconds spent to build current desc
+  int      nthr;       // number of threads used to build current desc
+  int      numa;       // NUMA placement applied to the tables (see mad_desc_numa)
+  unsigned gen;        // generation of the id, stamps the thread truncations
+
+  num_t    eps;        // pruning threshold of mul and compose results (0: none)
+  prune_stat_t pstat;  // pruning counters, updated atomically
 
   ord_t   *var_ords,   // limiting order for each monomial variable
           *map_ords,   // max order for each TPSA in map -- used just for desc comparison
-          *monos,      // 'matrix' storing the monomials (sorted by ord)
-          *ords,       // order of each mono of To
-         **To,         // Table by orders -- pointers to monos, sorted by order
-         **Tv,         // Table by vars   -- pointers to monos, sorted by vars
+          *monos,      // 'matrix' storing the monomials (sorted by ord), NULL if packed
+          *ords,       // order of each mono (sorted by ord)
+          *pshf,       // packed monos -- shift of each var in pmonos[i] (NULL if not packed)
+          *pmsk,       // packed monos -- mask  of each var in pmonos[i], 2^bits(var_ords)-1
          **ocs;        // ocs[t,i] = o; in mul, compute o on thread t; 3 <= o <= mo; terminated with 0
 
+  u64_t   *pmonos;     // packed monomials (sorted by ord), NULL if not packed
+
   idx_t   *sort_var,   // array
-          *ord2idx,    // order to polynomial start index in To (i.e. in TPSA coef[])
-          *tv2to,      // lookup tv->to
-          *to2tv,      // lookup to->tv
-          *H,          // indexing matrix, in Tv
+          *ord2idx,    // order to polynomial start index of monos (i.e. in TPSA coef[])
+          *R,          // ranking -- R[i,o,k] = #monos of vars [0,i) of ord o and knobs ord <= k
+          *tv2to,      // lookup tv->to       (MAD_DESC_VERIFY only)
+          *to2tv,      // lookup to->tv       (MAD_DESC_VERIFY only)
+          *H,          // indexing matrix, in tv2to (MAD_DESC_VERIFY only)
          **L,          // multiplication indexes -- L[oa][ob] = lc; lc[ia][ib] = ic
-        ***L_idx;      // L_idx[oa,ob] = [start] [split] [end] idxs in L
+        ***L_idx,      // L_idx[oa,ob] = [start] [split] [end] idxs in L
+          *K,          // knobs splitting -- K[i]..K[i+1] = range in K_idx for map mono i
+          *K_idx;      // K_idx[2*j] = coef idx, K_idx[2*j+1] = idx of its knob-only part
 
   // WARNING: temps must be used with care (internal side effects)
    tpsa_t * t[5];      // temps for mul[0], fix pts[1-3], div & funs[4], alg funs[1-3] for aliasing
   ctpsa_t *ct[5];      // temps for ctpsa
+  ftpsa_t *ft[5];      // temps for ftpsa
 };
 
+// --- globals ---------------------------------------------------------------o
+
+enum { TPSA_DESC_NUM = 100 };  // number of descriptors to store
+
+// per-thread truncation orders by desc id, stored as to+1 (0: use d->trunc),
+// valid only for the generation of the desc that set them (ids are reused)
+typedef struct { ord_t to; unsigned gen; } desc_ttrunc_t;
+extern desc_ttrunc_t mad_desc_ttrunc_[TPSA_DESC_NUM];
+
+#ifdef _OPENMP
+#pragma omp threadprivate(mad_desc_ttrunc_)
+#endif
+
 // --- interface -------------------------------------------------------------o
 
 #define D desc_t
@@ -76,11 +103,77 @@ void     mad_tpsa_del   (tpsa_t *t);
 ctpsa_t* mad_ctpsa_newd (D *d, ord_t mo);
 void     mad_ctpsa_del  (ctpsa_t *t);
 
+ftpsa_t* mad_ftpsa_newd (D *d, ord_t mo);
+void     mad_ftpsa_del  (ftpsa_t *t);
+
 // --- helpers ---------------------------------------------------------------o
 
 #undef  ensure
 #define ensure(test) assert(test)
 
+static inline const ord_t*
+desc_mono (const D *d, idx_t i, ord_t m[])
+{
+  // monomial i (sorted by ord), m[nv] is filled only if monos are packed
+  if (!d->pmonos) return d->monos + i*d->nv;
+
+  const u64_t p = d->pmonos[i];
+  for (int v = 0; v < d->nv; ++v)
+    m[v] = (p >> d->pshf[v]) & d->pmsk[v];
+  return m;
+}
+
+static inline ord_t
+desc_mono_var (const D *d, idx_t i, int v)
+{
+  // exponent of var v in monomial i
+  if (!d->pmonos) return d->monos[i*d->nv + v];
+  return (d->pmonos[i] >> d->pshf[v]) & d->pmsk[v];
+}
+
+static inline ord_t
+desc_tcur (const D *d)
+{
+  // truncation context of the calling thread (to+1, 0: none or stale)
+  const desc_ttrunc_t *tt = &mad_desc_ttrunc_[d->id];
+  return tt->gen == d->gen ? tt->to : 0;
+}
+
+static inline ord_t
+desc_trunc (const D *d)
+{
+  // truncation order of the calling thread, default to the global one
+  ord_t to = desc_tcur(d);
+  return to ? MIN(to-1, d->mo) : d->trunc;
+}
+
+static inline ord_t
+desc_tctx (const D *d, ord_t ctx)
+{
+  // swap the truncation context of the calling thread (to+1, 0: none)
+  ord_t old = desc_tcur(d);
+  mad_desc_ttrunc_[d->id] = (desc_ttrunc_t){ ctx, d->gen };
+  return old;
+}
+
+static inline void
+desc_pstat_add (D *d, u64_t coefs, u64_t ords)
+{
+  // pruning counters are shared by the threads
+#ifdef _OPENMP
+  #pragma omp atomic
+  d->pstat.calls += 1;
+  #pragma omp atomic
+  d->pstat.coefs += coefs;
+  #pragma omp atomic
+  d->pstat.ords  += ords;
+#else
+  d->pstat.calls += 1;
+  d->pstat.coefs += coefs;
+  d->pstat.ords  += ords;
+#endif
+}
+
 static inline idx_t
 hpoly_idx (idx_t ib, idx_t ia, idx_t ia_size)
 {
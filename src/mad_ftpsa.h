@@ -0,0 +1,183 @@
+#ifndef MAD_FTPSA_H
+#define MAD_FTPSA_H
+
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | Float Truncated Power Series Algebra module interface
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ |          C. Tomoiaga
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+  
+  Purpose:
+  - provide a full feathered Generalized TPSA package in single precision
+ 
+  Information:
+  - parameters ending with an underscope can be null.
+  - ftpsa shares the descriptors (and their temporaries) with tpsa and ctpsa,
+    mad_tpsa_float and mad_ftpsa_double convert from/to tpsa.
+  - coefficients are stored and computed in single precision, except the
+    linear algebra of minv and pminv which is done in double precision.
+  - on the 6D map of a FODO-like cell (drift and thin quadrupole/sextupole
+    kicks, nv=6, mo=2..8), ftpsa is 1.1-1.3x faster than tpsa with a relative
+    error of 1e-7..5e-7 after one cell and ~3e-6 after 4-5 cells (see
+    tests/benchmarks/tpsa/bench_ftpsa.c). High order coefficients can exceed
+    the float range (~3e38) after few turns (e.g. mo=7 after 10 cells).
+
+  Errors:
+  - like tpsa, the functions raise an error (ensure) for ftpsa built from
+    different descriptors, orders larger than the order of the descriptor
+    (e.g. mad_ftpsa_newd), indexes, monomials or variables out of range, and
+    functions evaluated outside of their domain (e.g. inv(0), log(x <= 0)).
+  - overflows of the float range are not detected and propagate as inf/nan.
+  - mad_ftpsa_scan is not implemented and raises an error, scan_hdr and
+    scan_coef raise an error on a malformed input.
+
+ o----------------------------------------------------------------------------o
+ */
+
+#include <stdio.h>
+
+#include "mad_mono.h"
+#include "mad_desc.h"
+
+// --- types -----------------------------------------------------------------o
+
+struct tpsa;
+
+typedef struct ftpsa ftpsa_t;
+
+// --- globals ---------------------------------------------------------------o
+
+extern const ord_t mad_tpsa_default;
+extern const ord_t mad_tpsa_same;
+extern       int   mad_tpsa_strict;
+
+// --- interface -------------------------------------------------------------o
+
+// ctors, dtor
+ftpsa_t* mad_ftpsa_newd    (desc_t *d, ord_t mo); // error if mo > d_mo
+ftpsa_t* mad_ftpsa_new     (const ftpsa_t *t, ord_t mo);
+ftpsa_t* mad_ftpsa_newr    (const ftpsa_t *t, ord_t mo); // in current region
+void     mad_ftpsa_del     (      ftpsa_t *t);
+
+// introspection
+desc_t*  mad_ftpsa_desc    (const ftpsa_t *t);
+ord_t    mad_ftpsa_ord     (const ftpsa_t *t);
+ord_t    mad_ftpsa_ordv    (const ftpsa_t *t1, const ftpsa_t *t2, ...);  // max order of all
+
+// initialization
+void     mad_ftpsa_copy    (const ftpsa_t *t, ftpsa_t *dst);
+void     mad_ftpsa_clear   (      ftpsa_t *t);
+void     mad_ftpsa_scalar  (      ftpsa_t *t, fnum_t v);
+idx_t    mad_ftpsa_prune   (      ftpsa_t *t, num_t eps); // zero |coef| < eps
+
+// conversion
+void     mad_ftpsa_double  (const ftpsa_t *t, struct tpsa *dst);
+
+// indexing / monomials
+int      mad_ftpsa_mono    (const ftpsa_t *t, int n,       ord_t m_[], idx_t i);
+int      mad_ftpsa_midx    (const ftpsa_t *t, int n, const ord_t m []);
+int      mad_ftpsa_midx_sp (const ftpsa_t *t, int n, const int   m []); // sparse mono [(i,o)]
+
+// accessors
+fnum_t   mad_ftpsa_get0    (const ftpsa_t *t);
+fnum_t   mad_ftpsa_geti    (const ftpsa_t *t, idx_t i);
+fnum_t   mad_ftpsa_getm    (const ftpsa_t *t, int n, const ord_t m[]);
+fnum_t   mad_ftpsa_getm_sp (const ftpsa_t *t, int n, const int   m[]); // sparse mono [(i,o)]
+void     mad_ftpsa_set0    (      ftpsa_t *t, /* i = 0 */             fnum_t a, fnum_t b);
+void     mad_ftpsa_seti    (      ftpsa_t *t, idx_t i,                fnum_t a, fnum_t b);
+void     mad_ftpsa_setm    (      ftpsa_t *t, int n, const ord_t m[], fnum_t a, fnum_t b);
+void     mad_ftpsa_setm_sp (      ftpsa_t *t, int n, const int   m[], fnum_t a, fnum_t b);
+
+// operations
+void     mad_ftpsa_abs     (const ftpsa_t *a, ftpsa_t *c);
+fnum_t   mad_ftpsa_nrm1    (const ftpsa_t *a, const ftpsa_t *b_);
+fnum_t   mad_ftpsa_nrm2    (const ftpsa_t *a, const ftpsa_t *b_);
+void     mad_ftpsa_der     (const ftpsa_t *a, ftpsa_t *c, int var);
+void     mad_ftpsa_mder    (const ftpsa_t *a, ftpsa_t *c, int n, const ord_t m[]);
+
+void     mad_ftpsa_add     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c);
+void     mad_ftpsa_sub     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c);
+void     mad_ftpsa_mul     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c);
+void     mad_ftpsa_div     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c);
+
+void     mad_ftpsa_acc     (const ftpsa_t *a, fnum_t v, ftpsa_t *c);  // c += v*a, aliasing OK
+void     mad_ftpsa_scl     (const ftpsa_t *a, fnum_t v, ftpsa_t *c);  // c  = v*a
+void     mad_ftpsa_inv     (const ftpsa_t *a, fnum_t v, ftpsa_t *c);  // c  = v/a
+void     mad_ftpsa_invsqrt (const ftpsa_t *a, fnum_t v, ftpsa_t *c);  // c  = v/sqrt(a)
+
+void     mad_ftpsa_sqrt    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_exp     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_log     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_sin     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_cos     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_sinh    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_cosh    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_sincos  (const ftpsa_t *a, ftpsa_t *s, ftpsa_t *c);
+void     mad_ftpsa_sincosh (const ftpsa_t *a, ftpsa_t *s, ftpsa_t *c);
+void     mad_ftpsa_sinc    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_sirx    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_corx    (const ftpsa_t *a, ftpsa_t *c);
+
+void     mad_ftpsa_tan     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_cot     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_asin    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_acos    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_atan    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_acot    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_tanh    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_coth    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_asinh   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_acosh   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_atanh   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_acoth   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_erf     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_ipow    (const ftpsa_t *a, ftpsa_t *c, int n);
+
+// high level functions
+void     mad_ftpsa_axpb       (fnum_t a, const ftpsa_t *x,
+                               fnum_t b, ftpsa_t *r);  // aliasing OK
+void     mad_ftpsa_axpbypc    (fnum_t a, const ftpsa_t *x,
+                               fnum_t b, const ftpsa_t *y,
+                               fnum_t c, ftpsa_t *r);  // aliasing OK
+void     mad_ftpsa_axypb      (fnum_t a, const ftpsa_t *x, const ftpsa_t *y,
+                               fnum_t b, ftpsa_t *r);  // aliasing OK
+void     mad_ftpsa_axypbzpc   (fnum_t a, const ftpsa_t *x, const ftpsa_t *y,
+                               fnum_t b, const ftpsa_t *z,
+                               fnum_t c, ftpsa_t *r);  // aliasing OK
+void     mad_ftpsa_axypbvwpc  (fnum_t a, const ftpsa_t *x, const ftpsa_t *y,
+                               fnum_t b, const ftpsa_t *v, const ftpsa_t *w,
+                               fnum_t c, ftpsa_t *r);  // aliasing OK
+void     mad_ftpsa_ax2pby2pcz2(fnum_t a, const ftpsa_t *x,
+                               fnum_t b, const ftpsa_t *y,
+                               fnum_t c, const ftpsa_t *z, ftpsa_t *r); // aliasing OK
+
+// to check for non-homogeneous maps & knobs
+void     mad_ftpsa_poisson (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c, int n);  // TO CHECK n
+void     mad_ftpsa_compose (int sa, const ftpsa_t *ma[], int sb, const ftpsa_t *mb[], int sc, ftpsa_t *mc[]);
+void     mad_ftpsa_minv    (int sa, const ftpsa_t *ma[],                              int sc, ftpsa_t *mc[]);
+void     mad_ftpsa_pminv   (int sa, const ftpsa_t *ma[],                              int sc, ftpsa_t *mc[], int row_select[]);
+
+// I/O
+void     mad_ftpsa_print    (const ftpsa_t *t, str_t name_, FILE *stream_);
+ftpsa_t* mad_ftpsa_scan     (                               FILE *stream_); // not implemented
+desc_t*  mad_ftpsa_scan_hdr (                               FILE *stream_);
+void     mad_ftpsa_scan_coef(      ftpsa_t *t,              FILE *stream_); // orders <= mo
+void     mad_ftpsa_debug    (const ftpsa_t *t);
+
+#define  mad_ftpsa_ordv(...) mad_ftpsa_ordv(__VA_ARGS__,NULL)
+
+// ---------------------------------------------------------------------------o
+
+#endif // MAD_FTPSA_H
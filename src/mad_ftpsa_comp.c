@@ -0,0 +1,2 @@
+#define   MAD_FTPSA_IMPL
+#include "mad_tpsa_comp.c"
@@ -0,0 +1,53 @@
+#ifndef MAD_FTPSA_IMPL_H
+#define MAD_FTPSA_IMPL_H
+
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | Float Truncated Power Series Algebra module implementation
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ |          C. Tomoiaga
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+*/
+
+#include "mad_bit.h"
+#include "mad_ftpsa.h"
+
+// --- types -----------------------------------------------------------------o
+
+struct ftpsa { // warning: must be kept identical to LuaJIT definition (cmad.lua)
+  desc_t *d;
+  ord_t   lo, hi, mo; // lowest/highest used ord, trunc ord
+  bit_t   nz;
+  fnum_t  coef[];
+};
+
+// --- helpers ---------------------------------------------------------------o
+
+#ifndef MAD_TPSA_NOHELPER
+
+#define T           ftpsa_t
+#define NUM         fnum_t
+#define FUN(name)   MKNAME(mad_ftpsa_,name)
+#define PFX(name)   MKNAME(f,name)
+#define VAL(num)    (num_t)(num)
+#define FMT         "%g"
+#define SELECT(R,C) R
+
+#endif
+
+#include <tgmath.h>
+
+// ---------------------------------------------------------------------------o
+
+#endif // MAD_FTPSA_IMPL_H
@@ -0,0 +1,604 @@
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | Map (TPSA) module implementation
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+*/
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "mad_mem.h"
+#include "mad_map.h"
+#include "mad_desc_impl.h"
+#include "mad_tpsa_impl.h"
+
+// --- types -----------------------------------------------------------------o
+
+enum { map_align = 64 }; // cache line
+enum { map_nblk  = 64 }; // max number of blocks for concatenation
+
+struct map {
+  desc_t *d;
+  int     n;      // number of components (d->nmv)
+  ord_t   mo;     // order of the components
+  tpsa_t *t[];    // components, stored in the same block after the pointers
+};
+
+struct map_tree {
+  int     n, sz;  // number of leaves, index of the first leaf (power of 2)
+  map_t **node;   // nodes [1..2sz), node[k] = node[2k+1] o node[2k]
+  char   *own;    // node[k] is owned, otherwise an alias of node[2k] or null
+  char   *dirty;  // node[k] must be recomputed, so are its ancestors
+};
+
+// --- LOCAL FUNCTIONS --------------------------------------------------------
+
+static inline size_t
+comp_size (const D *d)
+{
+  size_t s = sizeof(tpsa_t) + d->nc * sizeof(num_t);
+  return (s + map_align-1) & ~(size_t)(map_align-1);
+}
+
+static inline void
+check_same_map (const map_t *a, const map_t *b)
+{
+  assert(a && b);
+  ensure(a->d == b->d);
+}
+
+// --- PUBLIC FUNCTIONS -------------------------------------------------------
+
+// --- --- CTORS --------------------------------------------------------------
+
+map_t*
+mad_map_newd (D *d, ord_t mo)
+{
+  assert(d);
+
+  if (mo == mad_tpsa_default) mo = d->mo;
+  else ensure(mo <= d->mo);
+
+  int    n   = d->nmv;
+  size_t hsz = sizeof(map_t) + n * sizeof(tpsa_t*);
+  size_t csz = comp_size(d);
+
+  // one block: header, pointers, padding, components on cache lines
+  map_t *m = mad_malloc(hsz + map_align-1 + n*csz);
+  m->d  = d;
+  m->n  = n;
+  m->mo = mo;
+
+  uintptr_t p = ((uintptr_t)m + hsz + map_align-1) & ~(uintptr_t)(map_align-1);
+  for (int i = 0; i < n; ++i, p += csz) {
+    tpsa_t *t = (tpsa_t*)p;
+    t->d  = d;
+    t->lo = t->mo = mo;
+    t->hi = t->nz = t->coef[0] = 0;
+    m->t[i] = t;
+  }
+  return m;
+}
+
+map_t*
+mad_map_new (const map_t *m, ord_t mo)
+{
+  assert(m);
+  if (mo == mad_tpsa_same) mo = m->mo;
+  return mad_map_newd(m->d, mo);
+}
+
+void
+mad_map_del (map_t *m)
+{
+  mad_free(m);
+}
+
+// --- --- INTROSPECTION ------------------------------------------------------
+
+D*
+mad_map_desc (const map_t *m)
+{
+  assert(m);
+  return m->d;
+}
+
+ord_t
+mad_map_ord (const map_t *m)
+{
+  assert(m);
+  return m->mo;
+}
+
+int
+mad_map_len (const map_t *m)
+{
+  assert(m);
+  return m->n;
+}
+
+int
+mad_map_nknb (const map_t *m)
+{
+  assert(m);
+  return m->d->nv - m->d->nmv;
+}
+
+tpsa_t*
+mad_map_get (map_t *m, int i)
+{
+  assert(m);
+  ensure(0 <= i && i < m->n);
+  return m->t[i];
+}
+
+tpsa_t**
+mad_map_tpsa (map_t *m)
+{
+  assert(m);
+  return m->t;
+}
+
+// --- --- INITIALIZATION -----------------------------------------------------
+
+void
+mad_map_copy (const map_t *m, map_t *dst)
+{
+  check_same_map(m, dst);
+  if (m == dst) return;
+  for (int i = 0; i < m->n; ++i)
+    mad_tpsa_copy(m->t[i], dst->t[i]);
+}
+
+void
+mad_map_clear (map_t *m)
+{
+  assert(m);
+  for (int i = 0; i < m->n; ++i)
+    mad_tpsa_clear(m->t[i]);
+}
+
+void
+mad_map_ident (map_t *m)
+{
+  assert(m);
+  for (int i = 0; i < m->n; ++i) {
+    mad_tpsa_clear(m->t[i]);
+    mad_tpsa_seti (m->t[i], i+1, 0, 1);
+  }
+}
+
+// --- --- OPERATIONS ---------------------------------------------------------
+
+void
+mad_map_add (const map_t *a, const map_t *b, map_t *c)
+{
+  check_same_map(a, b);
+  check_same_map(a, c);
+  for (int i = 0; i < a->n; ++i)
+    mad_tpsa_add(a->t[i], b->t[i], c->t[i]);
+}
+
+void
+mad_map_sub (const map_t *a, const map_t *b, map_t *c)
+{
+  check_same_map(a, b);
+  check_same_map(a, c);
+  for (int i = 0; i < a->n; ++i)
+    mad_tpsa_sub(a->t[i], b->t[i], c->t[i]);
+}
+
+void
+mad_map_compose (const map_t *a, const map_t *b, map_t *c)
+{
+  check_same_map(a, b);
+  check_same_map(a, c);
+  int n = a->n;
+
+  if (c != a && c != b) {
+    mad_tpsa_compose(n, (const tpsa_t**)a->t, n, (const tpsa_t**)b->t, n, c->t);
+    return;
+  }
+
+  // aliasing, compose into a temporary map
+  map_t *r = mad_map_new(c, mad_tpsa_same);
+  mad_tpsa_compose(n, (const tpsa_t**)a->t, n, (const tpsa_t**)b->t, n, r->t);
+  mad_map_copy(r, c);
+  mad_map_del(r);
+}
+
+void
+mad_map_minv (const map_t *a, map_t *c)
+{
+  check_same_map(a, c);
+  int n = a->n;
+
+  if (c != a) {
+    mad_tpsa_minv(n, (const tpsa_t**)a->t, n, c->t);
+    return;
+  }
+
+  // aliasing, invert into a temporary map
+  map_t *r = mad_map_new(c, mad_tpsa_same);
+  mad_tpsa_minv(n, (const tpsa_t**)a->t, n, r->t);
+  mad_map_copy(r, c);
+  mad_map_del(r);
+}
+
+void
+mad_map_eval (const map_t *m, int nx, const num_t x[nx], int nr, num_t r[nr])
+{
+  assert(m && x && r);
+  D *d = m->d;
+  ensure(nx == d->nv && nr == m->n);
+
+  ord_t hi = 0;
+  for (int i = 0; i < m->n; ++i)
+    hi = MAX(hi, MIN(m->t[i]->hi, desc_trunc(d)));
+
+  // powers of x: pw[v*(hi+1)+o] = x[v]^o
+  int nc = d->ord2idx[hi+1], np = hi+1;
+  mad_alloc_tmp(num_t, pw, nx*np);
+  mad_alloc_tmp(num_t, mv, nc);
+
+  for (int v = 0; v < nx; ++v) {
+    pw[v*np] = 1;
+    for (int o = 1; o < np; ++o)
+      pw[v*np+o] = pw[v*np+o-1] * x[v];
+  }
+
+  // monomials values, shared by all components
+  ord_t mb[nx];
+  mv[0] = 1;
+  for (int c = 1; c < nc; ++c) {
+    const ord_t *mono = desc_mono(d, c, mb);
+    num_t val = 1;
+    for (int v = 0; v < nx; ++v)
+      if (mono[v]) val *= pw[v*np+mono[v]];
+    mv[c] = val;
+  }
+
+  // components
+  const idx_t *pi = d->ord2idx;
+  for (int i = 0; i < m->n; ++i) {
+    const tpsa_t *t = m->t[i];
+    num_t s = t->coef[0];
+    ord_t th = MIN(t->hi, desc_trunc(d));
+    for (int o = MAX(t->lo,1); o <= th; ++o)
+      if (mad_bit_get(t->nz,o))
+        for (int c = pi[o]; c < pi[o+1]; ++c)
+          s += t->coef[c] * mv[c];
+    r[i] = s;
+  }
+
+  mad_free_tmp(mv);
+  mad_free_tmp(pw);
+}
+
+num_t
+mad_map_nrm1 (const map_t *a, const map_t *b_)
+{
+  assert(a);
+  num_t nrm = 0;
+  if (b_) {
+    check_same_map(a, b_);
+    for (int i = 0; i < a->n; ++i)
+      nrm += mad_tpsa_nrm1(a->t[i], b_->t[i]);
+  }
+  else
+    for (int i = 0; i < a->n; ++i)
+      nrm += mad_tpsa_nrm1(a->t[i], NULL);
+  return nrm;
+}
+
+// --- --- CONCATENATION ------------------------------------------------------
+
+// blocks of consecutive maps are fixed by n only, see mad_map.h
+
+static inline int
+blk_size (int n)
+{
+  int nb = 1;
+  while (nb < map_nblk && (nb+1)*(nb+1) <= n) ++nb; // about sqrt(n) blocks
+  return (n + nb-1) / nb;
+}
+
+// r = m[e-1] o ... o m[i], t is a temporary, r and t are swapped if needed
+static inline void
+blk_concat (int i, int e, const map_t *m[], map_t **r, map_t **t)
+{
+  mad_map_copy(m[i], *r);
+  for (++i; i < e; ++i) {
+    map_t *c = *t;
+    mad_map_compose(m[i], *r, c);
+    *t = *r, *r = c;
+  }
+}
+
+void
+mad_map_concat (int n, const map_t *m[n], map_t *r)
+{
+  assert(m && r);
+  ensure(n > 0);
+  for (int i = 0; i < n; ++i) check_same_map(m[i], r);
+
+  const D *d = r->d;
+  const ord_t ctx = desc_tcur(d); // caller's truncation context
+  const int bs = blk_size(n), nb = (n + bs-1) / bs;
+  map_t *b[nb], *t[nb];
+
+  // blocks in parallel
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1) if (nb > 1)
+  #endif
+  for (int k = 0; k < nb; ++k) {
+    ord_t old = desc_tctx(d, ctx);
+    b[k] = mad_map_new(r, mad_tpsa_same);
+    t[k] = mad_map_new(r, mad_tpsa_same);
+    blk_concat(k*bs, MIN((k+1)*bs, n), m, &b[k], &t[k]);
+    desc_tctx(d, old);
+  }
+
+  // balanced tree of blocks, b[k] = b[k+s] o b[k]
+  for (int s = 1; s < nb; s *= 2) {
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic,1) if (nb > 2*s)
+    #endif
+    for (int k = 0; k < nb-s; k += 2*s) {
+      ord_t old = desc_tctx(d, ctx);
+      map_t *c = t[k];
+      mad_map_compose(b[k+s], b[k], c);
+      t[k] = b[k], b[k] = c;
+      desc_tctx(d, old);
+    }
+  }
+
+  mad_map_copy(b[0], r);
+  for (int k = 0; k < nb; ++k) mad_map_del(b[k]), mad_map_del(t[k]);
+}
+
+void
+mad_map_prefix (int n, const map_t *m[n], map_t *r[n])
+{
+  assert(m && r);
+  ensure(n > 0);
+  for (int i = 0; i < n; ++i) check_same_map(m[i], r[0]), check_same_map(r[i], r[0]);
+
+  const D *d = r[0]->d;
+  const ord_t ctx = desc_tcur(d); // caller's truncation context
+  const int bs = blk_size(n), nb = (n + bs-1) / bs;
+  map_t *g[nb], *t[nb];
+
+  // prefixes of the blocks in parallel, r[i] = m[i] o r[i-1], r can be m
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1) if (nb > 1)
+  #endif
+  for (int k = 0; k < nb; ++k) {
+    ord_t old = desc_tctx(d, ctx);
+    int i = k*bs, e = MIN(i+bs, n);
+    t[k] = mad_map_new(r[0], mad_tpsa_same);
+    mad_map_copy(m[i], r[i]);
+    for (++i; i < e; ++i) mad_map_compose(m[i], r[i-1], r[i]);
+    desc_tctx(d, old);
+  }
+
+  // sequential scan of the blocks, g[k] = concatenation up to block k
+  g[0] = r[MIN(bs, n)-1];
+  for (int k = 1; k < nb; ++k) {
+    g[k] = mad_map_new(r[0], mad_tpsa_same);
+    mad_map_compose(r[MIN((k+1)*bs, n)-1], g[k-1], g[k]);
+  }
+
+  // offsets of the blocks in parallel, r[i] = r[i] o g[k-1]
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1) if (nb > 2)
+  #endif
+  for (int k = 1; k < nb; ++k) {
+    ord_t old = desc_tctx(d, ctx);
+    int i = k*bs, e = MIN(i+bs, n);
+    for (; i < e-1; ++i) {
+      mad_map_compose(r[i], g[k-1], t[k]);
+      mad_map_copy(t[k], r[i]);
+    }
+    desc_tctx(d, old);
+  }
+
+  // last map of the blocks
+  for (int k = 1; k < nb; ++k) mad_map_copy(g[k], r[MIN((k+1)*bs, n)-1]);
+  for (int k = 1; k < nb; ++k) mad_map_del(g[k]);
+  for (int k = 0; k < nb; ++k) mad_map_del(t[k]);
+}
+
+// --- --- SEGMENT TREE -------------------------------------------------------
+
+// nodes covering the leaves [i,j) in tracking order, at most 2*log2(sz)
+static inline int
+tree_cover (const map_tree_t *t, int i, int j, const map_t *c[])
+{
+  const map_t *rc[64];
+  int nl = 0, nr = 0;
+  for (int l = i+t->sz, r = j+t->sz; l < r; l /= 2, r /= 2) {
+    if (l & 1) c [nl++] = t->node[l++];
+    if (r & 1) rc[nr++] = t->node[--r];
+  }
+  while (nr > 0) c[nl++] = rc[--nr];
+  return nl;
+}
+
+// r = m[j-1] o ... o m[i] from the nodes of an updated tree
+static void
+tree_range (const map_tree_t *t, int i, int j, map_t *r)
+{
+  const map_t *c[64] = { NULL }; // i < j, hence nc >= 1
+  int nc = tree_cover(t, i, j, c);
+  assert(nc >= 1 && c[0]);
+  if (nc == 1) { mad_map_copy(c[0], r); return; }
+
+  map_t *tmp = mad_map_new(r, mad_tpsa_same), *a = r, *b = tmp;
+  blk_concat(0, nc, c, &a, &b);
+  if (a != r) mad_map_copy(a, r);
+  mad_map_del(tmp);
+}
+
+map_tree_t*
+mad_map_tree_new (const map_t *m, int n)
+{
+  assert(m);
+  ensure(n > 0);
+
+  int sz = 1;
+  while (sz < n) sz *= 2;
+
+  map_tree_t *t = mad_malloc(sizeof *t);
+  t->n = n, t->sz = sz;
+  t->node  = mad_malloc(2*sz * sizeof *t->node );
+  t->own   = mad_malloc(2*sz * sizeof *t->own  );
+  t->dirty = mad_malloc(2*sz * sizeof *t->dirty);
+
+  // leaves, identity maps
+  for (int k = sz; k < 2*sz; ++k) {
+    map_t *l = k-sz < n ? mad_map_new(m, mad_tpsa_same) : NULL;
+    if (l) mad_map_ident(l);
+    t->node[k] = l, t->own[k] = !!l, t->dirty[k] = 0;
+  }
+
+  // nodes, the nodes without right child are aliases of their left child
+  for (int k = sz-1; k > 0; --k) {
+    map_t *l = t->node[2*k+1] ? mad_map_new(m, mad_tpsa_same) : t->node[2*k];
+    if (t->node[2*k+1]) mad_map_ident(l);
+    t->node[k] = l, t->own[k] = !!t->node[2*k+1], t->dirty[k] = 0;
+  }
+  t->node[0] = NULL, t->own[0] = t->dirty[0] = 0;
+  return t;
+}
+
+void
+mad_map_tree_del (map_tree_t *t)
+{
+  if (!t) return;
+  for (int k = 1; k < 2*t->sz; ++k)
+    if (t->own[k]) mad_map_del(t->node[k]);
+  mad_free(t->dirty);
+  mad_free(t->own);
+  mad_free(t->node);
+  mad_free(t);
+}
+
+int
+mad_map_tree_len (const map_tree_t *t)
+{
+  assert(t);
+  return t->n;
+}
+
+void
+mad_map_tree_set (map_tree_t *t, int i, const map_t *m)
+{
+  assert(t && m);
+  ensure(0 <= i && i < t->n);
+  map_t *l = t->node[t->sz+i];
+  check_same_map(m, l);
+  mad_map_copy(m, l);
+
+  // marked nodes have marked ancestors
+  for (int k = (t->sz+i)/2; k > 0 && !t->dirty[k]; k /= 2)
+    t->dirty[k] = 1;
+}
+
+int
+mad_map_tree_update (map_tree_t *t)
+{
+  assert(t);
+  const D *d = t->node[1]->d;
+  const ord_t ctx = desc_tcur(d); // caller's truncation context
+  int nc = 0;
+
+  // from the leaves to the root, the marked nodes of a level in parallel
+  for (int lo = t->sz/2; lo > 0; lo /= 2) {
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic,1) reduction(+:nc) if (lo > 1)
+    #endif
+    for (int k = lo; k < 2*lo; ++k) {
+      if (!t->dirty[k]) continue;
+      if (t->own[k]) {
+        ord_t old = desc_tctx(d, ctx);
+        mad_map_compose(t->node[2*k+1], t->node[2*k], t->node[k]);
+        desc_tctx(d, old);
+        ++nc;
+      }
+      t->dirty[k] = 0;
+    }
+  }
+  return nc;
+}
+
+void
+mad_map_tree_map (map_tree_t *t, int i, int j, map_t *r)
+{
+  assert(t && r);
+  ensure(0 <= i && i < j && j <= t->n);
+  check_same_map(t->node[1], r);
+
+  mad_map_tree_update(t);
+  tree_range(t, i, j, r);
+}
+
+void
+mad_map_tree_maps (map_tree_t *t, int no, const int pos[no], map_t *r[no])
+{
+  assert(t && pos && r);
+  for (int k = 0; k < no; ++k) {
+    ensure(0 < pos[k] && pos[k] <= t->n);
+    check_same_map(t->node[1], r[k]);
+  }
+
+  mad_map_tree_update(t);
+
+  const D *d = t->node[1]->d;
+  const ord_t ctx = desc_tcur(d); // caller's truncation context
+
+  // observation points in parallel, r[k] = m[pos[k]-1] o ... o m[0]
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1) if (no > 1)
+  #endif
+  for (int k = 0; k < no; ++k) {
+    ord_t old = desc_tctx(d, ctx);
+    tree_range(t, 0, pos[k], r[k]);
+    desc_tctx(d, old);
+  }
+}
+
+// --- --- I/O ----------------------------------------------------------------
+
+void
+mad_map_print (const map_t *m, str_t name_, FILE *stream_)
+{
+  assert(m);
+  for (int i = 0; i < m->n; ++i)
+    mad_tpsa_print(m->t[i], name_, stream_);
+}
+
+void
+mad_map_scan (map_t *m, FILE *stream_)
+{
+  assert(m);
+  for (int i = 0; i < m->n; ++i) {
+    desc_t *d = mad_tpsa_scan_hdr(stream_);
+    ensure(d == m->d);
+    mad_tpsa_scan_coef(m->t[i], stream_);
+  }
+}
+
+// ---------------------------------------------------------------------------o
@@ -0,0 +1,119 @@
+#ifndef MAD_MAP_H
+#define MAD_MAP_H
+
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | Map (TPSA) module interface
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+
+  Purpose:
+  - provide maps of real GTPSAs, i.e. one GTPSA per map variable, stored in a
+    single allocation with map-level operations.
+
+  Information:
+  - parameters ending with an underscope can be null.
+  - a map has d->nmv components (knobs are not components), each component is
+    a GTPSA of order mo with its coefficients aligned on a cache line.
+  - components returned by mad_map_get and mad_map_tpsa are owned by the map,
+    they can be used with any mad_tpsa function except mad_tpsa_del.
+  - mad_map_eval evaluates the map at x[nv] (map variables followed by knobs).
+  - mad_map_compose and mad_map_minv support aliasing of their arguments.
+  - mad_map_concat concatenates n maps in tracking order, r = m[n-1] o ... o
+    m[0], and mad_map_prefix computes all the partial concatenations, r[i] =
+    m[i] o ... o m[0], r can be m. The maps are split in about sqrt(n) blocks
+    (at most 64) of consecutive maps concatenated in parallel, then combined
+    as a balanced tree (concat) or through a sequential scan of the blocks
+    (prefix). The blocks depend only on n, hence the results do not depend on
+    the number of threads. The combinations compose full maps, which is more
+    expensive than composing element maps, hence they pay off with several
+    threads. The truncation order of the calling thread is used.
+  - a map tree is a segment tree over n maps (the leaves, initially identity)
+    where each node is the concatenation of its two children, which gives
+    the concatenation of any range of maps in O(log n) compositions. Setting
+    a leaf marks its ancestors and mad_map_tree_update recomputes only the
+    marked nodes, level by level in parallel, i.e. O(log n) compositions per
+    leaf changed. mad_map_tree_map returns r = m[j-1] o ... o m[i] for 0 <=
+    i < j <= n, and mad_map_tree_maps the maps from the first leaf to the
+    observation points pos[k] (i.e. i = 0, j = pos[k]) in parallel. Both
+    update the tree first, and like mad_map_concat the results depend only
+    on the leaves, not on the order of the changes or the number of threads.
+
+  Errors:
+  - maps from different descriptors are not compatible.
+  - mad_map_newd raises an error if mo is larger than the order of the
+    descriptor (use mad_tpsa_default for the maximum order).
+
+ o----------------------------------------------------------------------------o
+ */
+
+#include <stdio.h>
+
+#include "mad_desc.h"
+#include "mad_tpsa.h"
+
+// --- types -----------------------------------------------------------------o
+
+typedef struct map      map_t;
+typedef struct map_tree map_tree_t;
+
+// --- interface -------------------------------------------------------------o
+
+// ctors, dtor
+map_t*   mad_map_newd    (desc_t *d, ord_t mo); // error if mo > d_mo
+map_t*   mad_map_new     (const map_t *m, ord_t mo);
+void     mad_map_del     (      map_t *m);
+
+// introspection
+desc_t*  mad_map_desc    (const map_t *m);
+ord_t    mad_map_ord     (const map_t *m);
+int      mad_map_len     (const map_t *m); // number of components (map vars)
+int      mad_map_nknb    (const map_t *m); // number of knobs
+tpsa_t*  mad_map_get     (      map_t *m, int i);
+tpsa_t** mad_map_tpsa    (      map_t *m);
+
+// initialization
+void     mad_map_copy    (const map_t *m, map_t *dst);
+void     mad_map_clear   (      map_t *m);
+void     mad_map_ident   (      map_t *m); // m[i] = x[i]
+
+// operations
+void     mad_map_add     (const map_t *a, const map_t *b, map_t *c);
+void     mad_map_sub     (const map_t *a, const map_t *b, map_t *c);
+void     mad_map_compose (const map_t *a, const map_t *b, map_t *c); // c = a o b
+void     mad_map_minv    (const map_t *a,                 map_t *c); // c = a^-1
+void     mad_map_eval    (const map_t *m, int nx, const num_t x[nx], int nr, num_t r[nr]);
+num_t    mad_map_nrm1    (const map_t *a, const map_t *b_);
+
+// concatenation (parallel)
+void     mad_map_concat  (int n, const map_t *m[n], map_t *r);
+void     mad_map_prefix  (int n, const map_t *m[n], map_t *r[n]);
+
+// segment tree (incremental concatenation)
+map_tree_t* mad_map_tree_new    (const map_t *m, int n); // n leaves like m
+void        mad_map_tree_del    (      map_tree_t *t);
+int         mad_map_tree_len    (const map_tree_t *t);
+void        mad_map_tree_set    (      map_tree_t *t, int i, const map_t *m);
+int         mad_map_tree_update (      map_tree_t *t); // #compositions
+void        mad_map_tree_map    (      map_tree_t *t, int i, int j, map_t *r);
+void        mad_map_tree_maps   (      map_tree_t *t, int no, const int pos[no],
+                                                      map_t *r[no]);
+
+// I/O
+void     mad_map_print   (const map_t *m, str_t name_, FILE *stream_);
+void     mad_map_scan    (      map_t *m,              FILE *stream_);
+
+// ---------------------------------------------------------------------------o
+
+#endif // MAD_MAP_H
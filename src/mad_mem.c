@@ -16,8 +16,15 @@
  o----------------------------------------------------------------------------o
 */
 
+#ifdef MAD_MEM_HUGEPAGE
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#endif
+
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -35,6 +42,40 @@ Note about auto collect:
   If MAD_MEM_AUTOCOLLECT != 0, the memory allocator will bound the amount
   of cached memory to pool_max. Default is to bound the memory cached for
   OPENMP only. -DMAD_MEM_AUTOCOLLECT sets it to 1.
+
+Note about large objects:
+  Objects larger than mblk_max and up to mlrg_max are rounded to the next
+  power of 2 and cached in their class, whatever MAD_MEM_AUTOCOLLECT. The
+  amount of large objects cached is always bounded by cach_max, above that
+  they are returned to the system.
+
+Note about remote free (OpenMP only):
+  Each mblk records the id of the pool of the thread that allocated it. A
+  cachable mblk freed by another thread is pushed to the remote list of its
+  owner (lock-free MPSC list), which drains it into its slots on the next
+  cache miss or collect. At most pool_num-1 pools are registered, mblk of
+  other threads are freed locally. The pools are allocated on the heap by
+  their thread on first use and never freed, so the remote frees and the
+  statistics of a thread that exited stay valid (its cached mblk and the
+  mblk sent to it are not reused).
+
+Note about regions:
+  Regions are per thread and nested like a stack. mad_ralloc allocates mblk
+  by bumping a pointer in chunks of at least rgn_chk bytes, mad_free ignores
+  them and mad_region_end releases all of them in O(1) by restoring the mark
+  of the matching mad_region_begin. Released chunks are kept for reuse until
+  mad_mcollect.
+
+Note about statistics:
+  Each pool counts the allocations, frees, cache hits and misses, bytes in
+  use and peak by class (slots, large classes, others and regions). Region
+  mblk are all counted as freed by mad_region_end. If the tracer is enabled,
+  one mad_malloc or mad_ralloc out of trc_rate records its caller in a small
+  open addressing table of the pool keyed by the address of fname.
+
+Note about huge pages:
+  If MAD_MEM_HUGEPAGE is defined, objects of mhpg_min and more are aligned
+  on mhpg_min and advised to use transparent huge pages (Linux only).
 */
 
 #ifdef _OPENMP
@@ -47,6 +88,12 @@ Note about auto collect:
 #define CHK(...)
 #endif
 
+#ifdef _OPENMP
+#define RMT(...) __VA_ARGS__
+#else
+#define RMT(...)
+#endif
+
 #ifdef  MAD_MEM_AUTOCOLLECT
 #define MAC(...) __VA_ARGS__
 #define CAM(...) 
@@ -65,6 +112,7 @@ union mblk {
 
   struct { // used mblk
     unsigned slot;
+    unsigned info;    // id of the owner pool (0 if none) | rgn_bit
 CHK(unsigned mark; )
     union { // alignment of data
       ptrdiff_t s, *sp;
@@ -81,39 +129,95 @@ struct slot {
   union mblk *list;
 };
 
+// region chunk (bump allocator)
+struct rchk {
+  struct rchk *next;
+  size_t size, used; // in bytes
+  double data[];     // alignment of mblk
+};
+
+// region mark
+struct rmrk {
+  struct rchk *chk;
+  size_t used;
+  u64_t  live;       // statistics of region mblk at mark
+  ptrdiff_t bytes;
+};
+
 #define MARK 0xDEADC0DE // marker
 
 // sizes & offsets
 enum {
+  mblk_lg2 = 11,    // log2 of mblk_max
+  mlrg_lg2 = 23,    // log2 of mlrg_max
+
   mblk_stp = 1<< 4, // step size is 16 bytes
-  mblk_max = 1<<11, // max object size is 2kB
-  pool_max = 1<<24, // max cached size is 16MB
+  mblk_max = 1<<mblk_lg2, // max small object size is 2kB
+  mlrg_max = 1<<mlrg_lg2, // max large object size is 8MB
+  mhpg_min = 1<<21, // min object size for huge pages is 2MB
+  pool_max = 1<<24, // default max cached size is 16MB
 
   slot_max = mblk_max/mblk_stp, // 128 slots
-  cach_max = pool_max/mblk_stp, // 16MB in slots unit
+  mlrg_num = mlrg_lg2-mblk_lg2, // 12 classes (4kB..8MB)
+  pool_num = 256,   // max number of pools owning their mblk (i.e. threads)
+  rgn_chk  = 1<<20, // min size of region chunks is 1MB
+  rgn_max  = 64,    // max number of nested regions
+  mtrc_lg2 = 8,     // log2 of mtrc_max
+  mtrc_max = 1<<mtrc_lg2, // max number of callers traced per pool
   mblk_off = offsetof(union mblk, used.data),
 
   // sanity checks
   static_assert__mblk_stp_must_be_a_power_of_2 = 1/!(mblk_stp & (mblk_stp-1)),
-  static_assert__mblk_max_must_be_a_power_of_2 = 1/!(mblk_max & (mblk_max-1)),
+  static_assert__mhpg_min_must_be_a_power_of_2 = 1/!(mhpg_min & (mhpg_min-1)),
   static_assert__pool_max_must_be_a_power_of_2 = 1/!(pool_max & (pool_max-1))
 };
 
+// statistics classes
+enum {
+  mcls_oth = slot_max+mlrg_num, // not cached
+  mcls_rgn,                     // regions
+  mcls_num
+};
+
 // memory pool
 struct pool {
 MAC(
   size_t cached; )
+  size_t lcached;  // large objects cached, in slots unit
   struct slot slot[slot_max];
+  struct slot lrg [mlrg_num];
+  struct rchk *rfst, *rcur; // region chunks: first, current
+  int          rlvl;        // number of open regions
+  struct rmrk  rmrk[rgn_max];
+  mem_stat_t   stat[mcls_num]; // statistics by class
+  unsigned     tcnt;           // allocations since last trace
+  mem_trace_t  toth;           // traces not recorded (table full)
+  mem_trace_t  trc[mtrc_max];  // traces by caller
+RMT(
+  unsigned id;     // 0: not registered, pool_num: not owner
+  size_t rsent;    // #mblk freed by this thread and sent to their owner
+  size_t rrecv;    // #mblk freed by other threads and drained in this pool
+  union mblk *rlist __attribute__((aligned(64))); ) // remote frees (MPSC)
 };
 
 // --- locals ----------------------------------------------------------------o
 
-static struct pool pool[1];
-
 #ifdef _OPENMP
+static struct pool *pool; // see get_pool
 #pragma omp threadprivate(pool)
+#else
+static struct pool  pool[1];
 #endif
 
+static size_t cach_max = pool_max/mblk_stp; // in slots unit, shared
+static int    trc_rate = 0;                  // tracer sampling rate, shared
+
+const int mad_mstat_ncls = mcls_num;
+
+RMT(
+static struct pool *pools[pool_num]; // registered pools, by id
+static unsigned     pool_cnt;        // last id
+)
 // --- implementation --------------------------------------------------------o
 
 static inline union mblk*
@@ -135,39 +239,247 @@ get_size (size_t slot)
   return (slot+1) * mblk_stp + mblk_off;
 }
 
+static inline int
+get_class (size_t size)
+{
+  // class of large object size in ]mblk_max, mlrg_max]
+  return (CHAR_BIT*sizeof(long long) - __builtin_clzll(size-1)) - mblk_lg2 - 1;
+}
+
+static inline int
+get_lrg (size_t slot)
+{
+  // class of slot if its size is a power of 2 of the large objects, -1 otherwise
+  size_t size = (slot+1) * mblk_stp;
+  if (slot < slot_max || size > mlrg_max || (size & (size-1))) return -1;
+  return __builtin_ctzll(size) - mblk_lg2 - 1;
+}
+
+static inline size_t
+get_lrg_slot (int k)
+{
+  return get_slot((size_t)mblk_max << (k+1));
+}
+
+static inline union mblk*
+new_node (size_t slot, size_t size)
+{
+  size_t bsiz = size ? get_size(slot) : mblk_off; // header only for size 0
+#ifdef MAD_MEM_HUGEPAGE
+  if (size >= mhpg_min) {
+    void *ptr;
+    if (posix_memalign(&ptr, mhpg_min, bsiz)) return NULL;
+    madvise(ptr, bsiz & ~(size_t)(mhpg_min-1), MADV_HUGEPAGE);
+    return ptr;
+  }
+#endif
+  return malloc(bsiz);
+}
+
+#define rgn_bit (1u << 31) // mblk allocated in a region
+
+// -- statistics
+
+static inline size_t
+get_cap (size_t slot)
+{
+  // capacity of slot, size=0 gives 0 (special case)
+  return (slot+1) * mblk_stp;
+}
+
+static inline int
+get_cls (size_t slot)
+{
+  if (slot < slot_max) return slot;
+  int k = get_lrg(slot);
+  return k >= 0 ? slot_max+k : mcls_oth;
+}
+
+static inline void
+stat_alloc (struct pool *ppool, int cls, size_t slot, int hit)
+{
+  mem_stat_t *s = ppool->stat+cls;
+  s->allocs += 1;
+  s->hits   += hit; // misses are computed by mad_mstat
+  s->bytes  += get_cap(slot);
+  if (s->bytes > s->peak) s->peak = s->bytes;
+}
+
+static inline void
+stat_free (struct pool *ppool, int cls, size_t slot)
+{
+  mem_stat_t *s = ppool->stat+cls;
+  s->frees++;
+  s->bytes -= get_cap(slot);
+}
+
+static void __attribute__((noinline))
+put_trace (struct pool *ppool, str_t fname, size_t size)
+{
+  // open addressing with linear probing on the address of fname
+  ppool->tcnt = 0;
+  if (fname) {
+    mem_trace_t *trc = ppool->trc;
+    unsigned h = (u64_t)(uintptr_t)fname * 0x9E3779B97F4A7C15ull >> (64-mtrc_lg2);
+    for (int i = 0; i < mtrc_max; ++i, h = (h+1) & (mtrc_max-1))
+      if (trc[h].fname == fname || !trc[h].fname) {
+        trc[h].fname  = fname;
+        trc[h].count += 1;
+        trc[h].bytes += size;
+        return;
+      }
+  }
+  ppool->toth.count += 1;
+  ppool->toth.bytes += size;
+}
+
+#define TRC(ppool,fname,size) \
+  (trc_rate && ++(ppool)->tcnt >= (unsigned)trc_rate ? \
+   put_trace(ppool,fname,size) : (void)0)
+
+static inline int
+is_cachable (size_t slot)
+{
+  return slot < slot_max || get_lrg(slot) >= 0;
+}
+
 static inline void*
-init_node (union mblk *ptr, size_t slot)
+init_node (struct pool *ppool, union mblk *ptr, size_t slot)
 {
     ptr->used.slot = slot;
 CHK(ptr->used.mark = MARK; )
+    ptr->used.info = 0;
+RMT(ptr->used.info = ppool->id < pool_num ? ppool->id : 0; )
+    (void)ppool;
     return ptr->used.data;
 }
 
+static inline void
+put_local (struct pool *ppool, union mblk *ptr)
+{
+  size_t slot = ptr->used.slot;
+  struct slot *pptr = NULL;
+
+  if (slot < slot_max)
+    pptr = ppool->slot+slot;
+  else { // large object, cache it if its size is a class and bound is ok
+    int k = get_lrg(slot);
+    if (k >= 0 && ppool->lcached + slot+1 <= cach_max)
+      pptr = ppool->lrg+k, ppool->lcached += slot+1;
+  }
+
+  if (pptr) {
+    ptr->free.next = pptr->list, pptr->list = ptr;
+MAC(ppool->cached += slot+1;
+    if (ppool->cached > cach_max) mad_mcollect(); )
+  }
+  else free(ptr);
+}
+
+#ifdef _OPENMP
+
+static struct pool* __attribute__((noinline))
+new_pool (void)
+{
+  // aligned for rlist, never freed (may outlive its thread)
+  char *ptr = calloc(1, sizeof(struct pool) + 63);
+  if (!ptr)
+    (mad_error)(__func__, "out of memory");
+  return pool = (struct pool*)(((uintptr_t)ptr + 63) & ~(uintptr_t)63);
+}
+
+static inline struct pool*
+get_pool (void)
+{
+  struct pool *ppool = pool ? pool : new_pool();
+  if (!ppool->id) { // register the pool of this thread
+    unsigned id = __atomic_add_fetch(&pool_cnt, 1, __ATOMIC_RELAXED);
+    if (id < pool_num) __atomic_store_n(pools+id, ppool, __ATOMIC_RELEASE);
+    ppool->id = id < pool_num ? id : pool_num;
+  }
+  return ppool;
+}
+
+static inline void
+put_remote (struct pool *ppool, unsigned owner, union mblk *ptr)
+{
+  // push on the remote list of the owner, slot stays valid (next is in data)
+  struct pool *opool = __atomic_load_n(pools+owner, __ATOMIC_ACQUIRE);
+  union  mblk *head  = __atomic_load_n(&opool->rlist, __ATOMIC_RELAXED);
+  do ptr->used.data->vp = head;
+  while (!__atomic_compare_exchange_n(&opool->rlist, &head, ptr, 1,
+                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  ppool->rsent++;
+}
+
+static inline union mblk*
+get_remote (struct pool *ppool)
+{
+  // take the whole remote list (single consumer, no ABA)
+  if (!__atomic_load_n(&ppool->rlist, __ATOMIC_RELAXED)) return NULL;
+  return __atomic_exchange_n(&ppool->rlist, NULL, __ATOMIC_ACQUIRE);
+}
+
+static inline void
+drain_remote (struct pool *ppool)
+{
+  union mblk *ptr = get_remote(ppool), *nxt;
+  for (; ptr; ptr = nxt) {
+    nxt = ptr->used.data->vp;
+    put_local(ppool, ptr);
+    ppool->rrecv++;
+  }
+}
+
+#else
+
+static inline struct pool*
+get_pool (void)
+{
+  return pool;
+}
+
+#endif // _OPENMP
+
 // -- allocator
 
 void*
 (mad_malloc) (str_t fname, size_t size)
 {
   size_t slot = get_slot(size);
-  struct pool *ppool = pool;
-  struct slot *pptr = ppool->slot+slot;
+  struct pool *ppool = get_pool();
+  struct slot *pptr = NULL;
   union  mblk *ptr;
+  int cls = mcls_oth, hit = 0;
+
+  if (slot < slot_max)
+    pptr = ppool->slot+slot, cls = slot;
+  else if (size && size <= mlrg_max) { // large object, round to its class
+    int k = get_class(size);
+    slot = get_lrg_slot(k);
+    pptr = ppool->lrg+k, cls = slot_max+k;
+  }
+
+RMT(if (pptr && !pptr->list) drain_remote(ppool); )
 
-  if (slot < slot_max && pptr->list) {
-    ptr = pptr->list, pptr->list = ptr->free.next;
+  if (pptr && pptr->list) {
+    ptr = pptr->list, pptr->list = ptr->free.next, hit = 1;
+    if (slot >= slot_max) ppool->lcached -= slot+1;
 MAC(ppool->cached -= slot+1; )
   } else {
 MAC(if (ppool->cached > cach_max) mad_mcollect(); )
-    ptr = malloc(size ? get_size(slot) : 0);
+    ptr = new_node(slot, size);
     if (!ptr) {
       mad_mcollect();
-      ptr = malloc(size ? get_size(slot) : 0);
+      ptr = new_node(slot, size);
       if (!ptr)
         (mad_error)(fname, "out of memory (%lu bytes)", (unsigned long)size);
     }
   }
 
-  return init_node(ptr, slot);
+  stat_alloc(ppool, cls, slot, hit);
+  TRC(ppool, fname, get_cap(slot));
+  return init_node(ppool, ptr, slot);
 }
 
 void*
@@ -190,12 +502,22 @@ CHK(
   if (ptr->used.mark != MARK)
     (mad_error)(fname, "invalid pointer"); )
 
+  if (ptr->used.info & rgn_bit) { // region mblk, move to a new one
+    size_t osz = (ptr->used.slot+1) * mblk_stp;
+    void *nptr = (mad_ralloc)(fname, size);
+    return memcpy(nptr, ptr_, MIN(osz, size));
+  }
+
   size_t slot = get_slot(size);
+  if (slot >= slot_max && size <= mlrg_max) // large object, round to its class
+    slot = get_lrg_slot(get_class(size));
+  if (slot == ptr->used.slot) return ptr_;  // same capacity
 
+  struct pool *ppool = get_pool();
 MAC(
-  struct pool *ppool = pool;
   if (ppool->cached > cach_max) mad_mcollect(); )
 
+  size_t oslot = ptr->used.slot;
   ptr = realloc(ptr, size ? get_size(slot) : 0);
   if (!ptr) {
     mad_mcollect();
@@ -204,7 +526,9 @@ MAC(
       (mad_error)(fname, "out of memory (%lu bytes)", (unsigned long)size);
   }
 
-  return init_node(ptr, slot);
+  stat_free (ppool, get_cls(oslot), oslot);
+  stat_alloc(ppool, get_cls( slot),  slot, 0);
+  return init_node(ppool, ptr, slot);
 }
 
 void
@@ -219,17 +543,116 @@ CHK(
   if (ptr->used.mark != MARK)
     (mad_error)(fname, "invalid pointer"); )
 
-    size_t slot = ptr->used.slot;
+    if (ptr->used.info & rgn_bit) return; // released by mad_region_end
 
-    if (slot < slot_max) {
-      struct pool *ppool = pool;
-      struct slot *pptr = ppool->slot+slot;
-      ptr->free.next = pptr->list, pptr->list = ptr;
-MAC(  ppool->cached += slot+1;
-      if (ppool->cached > cach_max) mad_mcollect(); )
-    }
-    else free(ptr);
+    struct pool *ppool = get_pool();
+    stat_free(ppool, get_cls(ptr->used.slot), ptr->used.slot);
+
+RMT(unsigned owner = ptr->used.info;
+    if (owner && owner != ppool->id && is_cachable(ptr->used.slot)) {
+      put_remote(ppool, owner, ptr);
+      return;
+    })
+
+    put_local(ppool, ptr);
+  }
+}
+
+// -- regions
+
+static struct rchk*
+rgn_next (str_t fname, struct pool *ppool, size_t bsiz)
+{
+  // next chunk with at least bsiz bytes, reuse released chunks if possible
+  struct rchk **pnxt = ppool->rcur ? &ppool->rcur->next : &ppool->rfst;
+  struct rchk  *chk  = *pnxt;
+
+  if (!chk || chk->size < bsiz) { // insert a new chunk
+    size_t size = MAX(bsiz, (size_t)rgn_chk);
+    struct rchk *nchk = malloc(sizeof *nchk + size);
+    if (!nchk)
+      (mad_error)(fname, "out of memory (%lu bytes)", (unsigned long)size);
+    nchk->next = chk, nchk->size = size;
+    *pnxt = chk = nchk;
+  }
+
+  chk->used = 0;
+  return ppool->rcur = chk;
+}
+
+static size_t
+rgn_spare (struct pool *ppool, int collect)
+{
+  // size of released chunks after the current one, free them if collect
+  struct rchk **pnxt = ppool->rcur ? &ppool->rcur->next : &ppool->rfst;
+  struct rchk  *chk  = *pnxt, *nxt;
+  size_t size = 0;
+
+  for (; chk; chk = nxt) {
+    nxt = chk->next;
+    size += chk->size;
+    if (collect) free(chk);
   }
+  if (collect) *pnxt = NULL;
+  return size;
+}
+
+int
+mad_region_begin (void)
+{
+  struct pool *ppool = get_pool();
+  if (ppool->rlvl == rgn_max)
+    (mad_error)(__func__, "too many nested regions (%d)", rgn_max);
+
+  struct rchk *chk = ppool->rcur;
+  struct rmrk *mrk = ppool->rmrk + ppool->rlvl;
+  mem_stat_t  *s   = ppool->stat + mcls_rgn;
+  mrk->chk   = chk;
+  mrk->used  = chk ? chk->used : 0;
+  mrk->live  = s->allocs - s->frees;
+  mrk->bytes = s->bytes;
+  return ++ppool->rlvl;
+}
+
+void
+mad_region_end (void)
+{
+  struct pool *ppool = get_pool();
+  if (!ppool->rlvl)
+    (mad_error)(__func__, "no region to end");
+
+  struct rmrk *mrk = ppool->rmrk + --ppool->rlvl;
+  mem_stat_t  *s   = ppool->stat + mcls_rgn;
+  ppool->rcur = mrk->chk;
+  if (mrk->chk) mrk->chk->used = mrk->used;
+  s->frees = s->allocs - mrk->live;
+  s->bytes = mrk->bytes;
+}
+
+void*
+(mad_ralloc) (str_t fname, size_t size)
+{
+  struct pool *ppool = get_pool();
+  if (!ppool->rlvl) return (mad_malloc)(fname, size);
+
+  size_t slot = get_slot(size ? size : 1);
+  size_t bsiz = (get_size(slot) + mblk_stp-1) & ~(size_t)(mblk_stp-1);
+  struct rchk *chk = ppool->rcur;
+  int hit = 1;
+
+  if (!chk || chk->used + bsiz > chk->size)
+    chk = rgn_next(fname, ppool, bsiz), hit = 0;
+
+  stat_alloc(ppool, mcls_rgn, slot, hit);
+  TRC(ppool, fname, get_cap(slot));
+
+  union mblk *ptr = (union mblk*)((char*)chk->data + chk->used);
+  chk->used += bsiz;
+
+    ptr->used.slot = slot;
+    ptr->used.info = rgn_bit;
+CHK(ptr->used.mark = MARK; )
+    return ptr->used.data;
 }
 
 // -- utils
@@ -263,7 +686,7 @@ CHK(
 size_t __attribute__((noinline))
 (mad_mcached) (void)
 {
-  struct pool *ppool = pool;
+  struct pool *ppool = get_pool();
   size_t cached = 0;
 CAM(
   union mblk *ptr;
@@ -272,20 +695,28 @@ CAM(
     struct slot *pptr = ppool->slot+slot;
     for (ptr=pptr->list; ptr; ptr=ptr->free.next)
       cached += slot+1;
-  })
+  }
+  cached += ppool->lcached; )
 MAC(
   cached = ppool->cached; )
 
-  return cached * mblk_stp;
+  return cached * mblk_stp + rgn_spare(ppool, 0);
 }
 
 // note: noinline improves speed of malloc and realloc for GCC 4.8 to 5.3
 size_t __attribute__((noinline))
 (mad_mcollect) (void)
 {
-  struct pool *ppool = pool;
+  struct pool *ppool = get_pool();
   union mblk *ptr, *nxt;
-  size_t cached = 0;
+  size_t cached = 0, rcached = 0;
+
+RMT( // pending remote frees
+  for (ptr=get_remote(ppool); ptr; ptr=nxt, ppool->rrecv++) {
+    nxt = ptr->used.data->vp;
+    rcached += ptr->used.slot+1;
+    free(ptr);
+  })
 
   for (int slot=0; slot < slot_max; slot++) {
     struct slot *pptr = ppool->slot+slot;
@@ -296,9 +727,206 @@ CAM(  cached += slot+1; )
     }
     pptr->list = 0;
   }
+
+  for (int k=0; k < mlrg_num; k++) {
+    struct slot *pptr = ppool->lrg+k;
+    for (ptr=pptr->list; ptr; ptr=nxt) {
+      nxt = ptr->free.next;
+      free(ptr);
+    }
+    pptr->list = 0;
+  }
+CAM(
+  cached += ppool->lcached; )
+  ppool->lcached = 0;
 MAC(
   cached = ppool->cached;
   ppool->cached = 0; )
 
-  return cached * mblk_stp;
+  return (cached + rcached) * mblk_stp + rgn_spare(ppool, 1);
+}
+
+size_t
+(mad_mremote) (size_t *recv_)
+{
+  size_t sent = 0, recv = 0;
+RMT(
+  struct pool *ppool = get_pool();
+  sent = ppool->rsent, recv = ppool->rrecv; )
+  if (recv_) *recv_ = recv;
+  return sent;
+}
+
+size_t
+(mad_mcachemax) (size_t max_)
+{
+  size_t max = cach_max * mblk_stp;
+  if (max_) cach_max = max_ / mblk_stp;
+  return max;
+}
+
+// -- statistics & tracing
+
+static int
+get_pools (struct pool *pp[pool_num])
+{
+  int n = 0;
+#ifdef _OPENMP
+  get_pool(); // register the pool of this thread
+  unsigned cnt = __atomic_load_n(&pool_cnt, __ATOMIC_RELAXED);
+  for (unsigned id = 1; id <= cnt && id < pool_num; id++) {
+    struct pool *ppool = __atomic_load_n(pools+id, __ATOMIC_ACQUIRE);
+    if (ppool) pp[n++] = ppool;
+  }
+#else
+  pp[n++] = pool;
+#endif
+  return n;
+}
+
+int
+(mad_mstat) (int nt, mem_stat_t stat_[])
+{
+  struct pool *pp[pool_num];
+  int n = get_pools(pp);
+
+  if (stat_)
+    for (int t = 0; t < n && t < nt; t++)
+      for (int c = 0; c < mcls_num; c++) {
+        mem_stat_t *s = stat_ + t*mcls_num + c;
+        *s = pp[t]->stat[c];
+        s->misses = s->allocs - s->hits;
+      }
+  return n;
+}
+
+size_t
+(mad_mstat_size) (int cls)
+{
+  ensure(cls >= 0 && cls < mcls_num, "invalid class %d", cls);
+  if (cls < slot_max) return get_cap(cls);
+  if (cls < mcls_oth) return get_cap(get_lrg_slot(cls-slot_max));
+  return 0;
+}
+
+void
+(mad_mstat_reset) (void)
+{
+  struct pool *pp[pool_num];
+  int n = get_pools(pp);
+
+  for (int t = 0; t < n; t++) {
+    struct pool *ppool = pp[t];
+    for (int c = 0; c < mcls_num; c++) {
+      mem_stat_t *s = ppool->stat+c;
+      ptrdiff_t bytes = s->bytes;
+      *s = (mem_stat_t){ .bytes = bytes, .peak = bytes };
+    }
+    for (int l = 0; l < ppool->rlvl; l++) // restart counts of open regions
+      ppool->rmrk[l].live = 0;
+    ppool->tcnt = 0;
+    ppool->toth = (mem_trace_t){ 0 };
+    memset(ppool->trc, 0, sizeof ppool->trc);
+  }
+}
+
+int
+(mad_mtrace) (int rate_)
+{
+  int rate = trc_rate;
+  if (rate_ >= 0) trc_rate = rate_;
+  return rate;
+}
+
+static int
+cmp_name (const void *a_, const void *b_)
+{
+  const mem_trace_t *a = a_, *b = b_;
+  return strcmp(a->fname, b->fname);
+}
+
+static int
+cmp_count (const void *a_, const void *b_)
+{
+  const mem_trace_t *a = a_, *b = b_;
+  return (a->count < b->count) - (a->count > b->count);
+}
+
+int
+(mad_mtrace_snapshot) (int n, mem_trace_t trc_[])
+{
+  struct pool *pp[pool_num];
+  int np = get_pools(pp);
+
+  // collect callers of all pools, merge them by name, sort them by count
+  mem_trace_t *trc = malloc((np*mtrc_max+1) * sizeof *trc);
+  if (!trc)
+    (mad_error)(__func__, "out of memory");
+
+  int m = 0;
+  mem_trace_t oth = { .fname = "(other)" };
+  for (int t = 0; t < np; t++) {
+    for (int i = 0; i < mtrc_max; i++)
+      if (pp[t]->trc[i].fname) trc[m++] = pp[t]->trc[i];
+    oth.count += pp[t]->toth.count;
+    oth.bytes += pp[t]->toth.bytes;
+  }
+
+  qsort(trc, m, sizeof *trc, cmp_name);
+  int k = 0;
+  for (int i = 0; i < m; i++)
+    if (k && !strcmp(trc[k-1].fname, trc[i].fname))
+      trc[k-1].count += trc[i].count, trc[k-1].bytes += trc[i].bytes;
+    else
+      trc[k++] = trc[i];
+  if (oth.count) trc[k++] = oth;
+
+  qsort(trc, k, sizeof *trc, cmp_count);
+  if (trc_)
+    memcpy(trc_, trc, MIN(n,k) * sizeof *trc);
+  free(trc);
+  return MIN(n,k);
+}
+
+void
+(mad_mstat_print) (FILE *stream_)
+{
+  if (!stream_) stream_ = stdout;
+
+  int nt = mad_mstat(0, NULL);
+  mem_stat_t *stat = malloc(nt * sizeof(mem_stat_t[mcls_num]));
+  if (!stat)
+    (mad_error)(__func__, "out of memory");
+  nt = mad_mstat(nt, stat);
+
+  fprintf(stream_, "%-4s %8s %12s %12s %12s %12s %14s %14s\n",
+          "thrd", "class", "allocs", "frees", "hits", "misses", "bytes", "peak");
+  for (int t = 0; t < nt; t++)
+    for (int c = 0; c < mcls_num; c++) {
+      const mem_stat_t *s = stat + t*mcls_num + c;
+      if (!s->allocs && !s->frees && !s->bytes) continue;
+      char cls[16];
+      if (c < mcls_oth) snprintf(cls, sizeof cls, "%zu", mad_mstat_size(c));
+      else              snprintf(cls, sizeof cls, "%s", c == mcls_oth ? "other" : "region");
+      fprintf(stream_, "%-4d %8s %12llu %12llu %12llu %12llu %14lld %14lld\n",
+              t, cls, (unsigned long long)s->allocs, (unsigned long long)s->frees,
+              (unsigned long long)s->hits, (unsigned long long)s->misses,
+              (long long)s->bytes, (long long)s->peak);
+    }
+  free(stat);
+
+  if (!trc_rate) return;
+
+  int n = mad_mtrace_snapshot(INT_MAX, NULL);
+  mem_trace_t *trc = malloc((n+1) * sizeof *trc);
+  if (!trc)
+    (mad_error)(__func__, "out of memory");
+  n = mad_mtrace_snapshot(n, trc);
+
+  fprintf(stream_, "\n%-32s %12s %14s (1/%d sampled)\n",
+          "caller", "count", "bytes", trc_rate);
+  for (int i = 0; i < n; i++)
+    fprintf(stream_, "%-32s %12llu %14llu\n", trc[i].fname,
+            (unsigned long long)trc[i].count, (unsigned long long)trc[i].bytes);
+  free(trc);
 }
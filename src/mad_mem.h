@@ -24,6 +24,8 @@
   - allocated memory can be used-by/moved-to any thread (global allocator).
   - temporary allocation are only for local use (scoped), and the length
     corresponds to the number of elements of type 'type' in the buffer.
+  - regions (per-thread, nested) release all their allocations at once.
+  - per-thread statistics by size class and sampling tracer of the callers.
 
   Information:
   - parameters ending with an underscope can be null.
@@ -32,8 +34,39 @@
   - mad_calloc calls mad_malloc and set to zeros the allocated memory.
   - mad_mcached returns the amount of memory cached (slow).
   - mad_mcollect frees the cached memory and returns its amount (slow).
+  - mad_mcachemax sets the maximum amount of memory cached per thread if max_
+    is not zero and returns the previous maximum (default 16MB).
+  - mad_mremote returns the number of blocks freed by the current thread and
+    returned to the pool of the thread that allocated them, and sets recv_ to
+    the number of blocks freed by other threads returned to its pool (OpenMP).
+  - objects up to 2kB are cached by steps of 16 bytes, objects up to 8MB are
+    rounded to the next power of 2 and cached by size classes.
+  - defining MAD_MEM_HUGEPAGE backs objects of 2MB and more with transparent
+    huge pages (Linux only).
   - temporay buffers can be either on the stack or allocated with mad_malloc
     depending on their size, and must _always_ be locally freed.
+  - mad_region_begin opens a new region in the current thread and returns its
+    nesting level, mad_region_end releases all the memory allocated by
+    mad_ralloc since the matching mad_region_begin in O(1).
+  - mad_ralloc allocates in the current region of the thread, or calls
+    mad_malloc if no region is open. mad_free ignores region memory, so code
+    can (and should) still free it, e.g. to work with MAD_MEM_STD.
+  - memory from a region must not be used after the end of the region.
+  - mad_mstat copies the counters of up to nt threads (if stat_ is not null)
+    into stat_[nt*mad_mstat_ncls] and returns the number of threads. Classes
+    are the cached sizes (see mad_mstat_size), followed by the other sizes
+    and the regions (size 0). Counters are always on and bytes are counted
+    by capacity. A block freed by another thread is counted by the freeing
+    thread, hence bytes in use of a thread can be negative.
+  - mad_mtrace sets the sampling rate of the tracer to one allocation out of
+    rate_ per thread (0 disables) if rate_ is not negative and returns the
+    previous rate (default 0). mad_mtrace_snapshot merges the callers sampled
+    by all threads, sorts them by decreasing count and copies up to n of them
+    into trc_, and returns their number. At most 256 callers are recorded per
+    thread, other samples are accounted to the caller "(other)".
+  - mad_mstat_reset clears the counters and the sampled callers of all
+    threads except the bytes in use, peaks restart from the bytes in use.
+  - snapshots and resets of other threads are racy (OpenMP).
   - defining MAD_MEM_STD replaces mad allocator by C allocator
 
   Errors:
@@ -43,8 +76,24 @@
  o----------------------------------------------------------------------------o
  */
 
+#include <stdio.h>
 #include "mad_defs.h"
 
+// --- types -----------------------------------------------------------------o
+
+typedef struct mem_stat  mem_stat_t;
+typedef struct mem_trace mem_trace_t;
+
+struct mem_stat {
+  u64_t allocs, frees, hits, misses; // hits/misses: served by the cache or not
+  ptrdiff_t bytes, peak;             // bytes in use and peak
+};
+
+struct mem_trace {
+  str_t fname;         // caller
+  u64_t count, bytes;  // sampled allocations and bytes
+};
+
 // --- interface -------------------------------------------------------------o
 
 // local buffer
@@ -57,10 +106,29 @@
 #define mad_realloc( ptr_ , size_ )
 #define mad_free(    ptr_         )
 #define mad_msize(   ptr_         )
+#define mad_ralloc(  size         )
 
 // utils
 size_t mad_mcached  (void);
 size_t mad_mcollect (void);
+size_t mad_mcachemax(size_t max_);
+size_t mad_mremote  (size_t *recv_);
+
+// regions
+int    mad_region_begin (void);
+void   mad_region_end   (void);
+
+// statistics & tracing
+int    mad_mstat          (int nt, mem_stat_t stat_[/*nt*mad_mstat_ncls*/]);
+size_t mad_mstat_size     (int cls); // capacity of class cls
+void   mad_mstat_reset    (void);
+void   mad_mstat_print    (FILE *stream_);
+int    mad_mtrace         (int rate_);
+int    mad_mtrace_snapshot(int n, mem_trace_t trc_[/*n*/]);
+
+// --- globals ---------------------------------------------------------------o
+
+extern const int mad_mstat_ncls;
 
 // --- implementation (private) ----------------------------------------------o
 
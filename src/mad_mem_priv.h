@@ -26,6 +26,7 @@
 #undef mad_realloc
 #undef mad_free
 #undef mad_msize
+#undef mad_ralloc
 
 #ifndef MAD_MEM_STD
 
@@ -34,6 +35,7 @@
 #define mad_realloc(p,s) mad_realloc(__func__, p,s)
 #define mad_free(p)      mad_free   (__func__, p)
 #define mad_msize(p)     mad_msize  (__func__, p)
+#define mad_ralloc(s)    mad_ralloc (__func__, s)
 
 #else
 
@@ -43,6 +45,7 @@
 #define mad_realloc(p,s) mad_mcheck(__func__, realloc(p,s))
 #define mad_free(p)                           free   (p)
 #define mad_msize(p)                                 (0)
+#define mad_ralloc(s)    mad_mcheck(__func__, malloc (s))
 
 #endif // MAD_MEM_STD
 
@@ -52,6 +55,7 @@ void*  (mad_realloc)  (str_t, void* , size_t) __attribute__((hot));
 void   (mad_free)     (str_t, void*)          __attribute__((hot));
 size_t (mad_msize)    (str_t, void*)          __attribute__((hot,const));
 void*  (mad_mcheck)   (str_t, void*)          __attribute__((hot,const));
+void*  (mad_ralloc)   (str_t, size_t)         __attribute__((hot,malloc));
 
 #undef  mad_alloc_tmp
 #define mad_alloc_tmp(T,NAME,L) \
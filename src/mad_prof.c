@@ -0,0 +1,111 @@
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | Profiling module implementation
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+*/
+
+#include <string.h>
+#include <assert.h>
+
+#include "mad_log.h"
+#include "mad_prof.h"
+
+// --- globals ---------------------------------------------------------------o
+
+const int mad_prof_enabled = MAD_PROF;
+
+#if MAD_PROF
+const int mad_prof_maxthread = MAD_PROF_MAXTHREAD;
+struct prof_thread mad_prof_thread[MAD_PROF_MAXTHREAD];
+#else
+const int mad_prof_maxthread = 1;
+#endif
+
+// --- locals ----------------------------------------------------------------o
+
+static const str_t prof_names[prof_nop] = {
+  [prof_mul        ] = "mul",
+  [prof_mul_ser    ] = "mul_ser",
+  [prof_mul_par    ] = "mul_par",
+  [prof_compose    ] = "compose",
+  [prof_compose_ser] = "compose_ser",
+  [prof_compose_par] = "compose_par",
+  [prof_minv       ] = "minv",
+  [prof_pminv      ] = "pminv",
+  [prof_fun        ] = "fun",
+};
+
+// --- implementation --------------------------------------------------------o
+
+str_t
+mad_prof_name (int op)
+{
+  ensure(op >= 0 && op < prof_nop, "invalid profiling operation %d", op);
+  return prof_names[op];
+}
+
+int
+mad_prof_snapshot (int nt, prof_stat_t stat[])
+{
+  assert(stat);
+  memset(stat, 0, nt * prof_nop * sizeof *stat);
+
+  int used = 0;
+#if MAD_PROF
+  for (int t = 0; t < nt && t < MAD_PROF_MAXTHREAD; ++t) {
+    memcpy(stat + t*prof_nop, mad_prof_thread[t].stat, prof_nop * sizeof *stat);
+    for (int op = 0; op < prof_nop; ++op)
+      if (stat[t*prof_nop+op].calls) { used = t+1; break; }
+  }
+#endif
+  return used;
+}
+
+void
+mad_prof_reset (void)
+{
+#if MAD_PROF
+  memset(mad_prof_thread, 0, sizeof mad_prof_thread);
+#endif
+}
+
+void
+mad_prof_print (FILE *stream_)
+{
+  if (!stream_) stream_ = stdout;
+
+  if (!mad_prof_enabled) {
+    fprintf(stream_, "profiling disabled (compile with -DMAD_PROF=1)\n");
+    return;
+  }
+
+  int nt = mad_prof_maxthread;
+  prof_stat_t stat[nt * prof_nop];
+  nt = mad_prof_snapshot(nt, stat);
+
+  fprintf(stream_, "%-4s %-12s %12s %10s %14s %16s %12s\n",
+          "thrd", "operation", "calls", "avg_ord", "coefs", "cycles", "cycles/call");
+  for (int t = 0; t < nt; ++t)
+    for (int op = 0; op < prof_nop; ++op) {
+      const prof_stat_t *s = &stat[t*prof_nop+op];
+      if (!s->calls) continue;
+      fprintf(stream_, "%-4d %-12s %12llu %10.2f %14llu %16llu %12.0f\n",
+              t, prof_names[op], (unsigned long long)s->calls,
+              (double)s->ords / s->calls, (unsigned long long)s->coefs,
+              (unsigned long long)s->cycles, (double)s->cycles / s->calls);
+    }
+}
+
+// ---------------------------------------------------------------------------o
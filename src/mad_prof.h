@@ -0,0 +1,119 @@
+#ifndef MAD_PROF_H
+#define MAD_PROF_H
+
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | Profiling module interface
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+
+  Purpose:
+  - per-thread counters for the hot paths of the GTPSA library: mul (and its
+    serial/parallel kernels), compose (serial/parallel), minv, pminv and
+    functions (fixed point iterations).
+  - snapshot, reset and print of the counters from C and Lua.
+
+  Information:
+  - counters are compiled only if MAD_PROF != 0 (e.g. -DMAD_PROF=1),
+    otherwise the macros PROF_BEG and PROF_END expand to nothing and the
+    snapshots are zeros.
+  - each counter records the number of calls, the sum of the orders involved,
+    the sum of the coefficients touched (size of the result up to its highest
+    order) and the cumulative cycles (or clock ticks on non-x86 platforms).
+  - counters are inclusive, i.e. the cycles spent in mul called by compose
+    are also accounted by compose. Real and complex GTPSA share the counters.
+  - threads with id >= mad_prof_maxthread share the last slot (racy).
+
+ o----------------------------------------------------------------------------o
+ */
+
+#include <stdio.h>
+#include "mad_defs.h"
+
+// --- types -----------------------------------------------------------------o
+
+enum prof_op {
+  prof_mul, prof_mul_ser, prof_mul_par,
+  prof_compose, prof_compose_ser, prof_compose_par,
+  prof_minv, prof_pminv, prof_fun,
+  prof_nop // number of operations
+};
+
+typedef struct prof_stat prof_stat_t;
+
+struct prof_stat {
+  u64_t calls, ords, coefs, cycles;
+};
+
+// --- interface -------------------------------------------------------------o
+
+int   mad_prof_snapshot (int nt, prof_stat_t stat[/*nt*prof_nop*/]); // return #threads used
+void  mad_prof_reset    (void);
+void  mad_prof_print    (FILE *stream_);
+str_t mad_prof_name     (int op);
+
+// --- globals ---------------------------------------------------------------o
+
+extern const int mad_prof_enabled;
+extern const int mad_prof_maxthread;
+
+// --- implementation (private) ----------------------------------------------o
+
+#ifndef MAD_PROF
+#define MAD_PROF 0
+#endif
+
+#if MAD_PROF
+
+#define MAD_PROF_MAXTHREAD 64
+
+#define PROF_BEG(op)        u64_t prof_clk_##op = mad_prof_clock()
+#define PROF_END(op,o,n)    mad_prof_add(op, prof_clk_##op, o, n)
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define mad_prof_clock()    ((u64_t)__rdtsc())
+#else
+#include <time.h>
+#define mad_prof_clock()    ((u64_t)clock())
+#endif
+
+struct prof_thread {
+  prof_stat_t stat[prof_nop];
+  char pad[64];             // avoid false sharing between threads
+};
+
+extern struct prof_thread mad_prof_thread[MAD_PROF_MAXTHREAD];
+
+static inline void
+mad_prof_add (enum prof_op op, u64_t clk, u64_t o, u64_t n)
+{
+  int t = omp_get_thread_num();
+  prof_stat_t *s = &mad_prof_thread[t < MAD_PROF_MAXTHREAD ? t : MAD_PROF_MAXTHREAD-1].stat[op];
+  s->calls  += 1;
+  s->ords   += o;
+  s->coefs  += n;
+  s->cycles += mad_prof_clock() - clk;
+}
+
+#else
+
+#define PROF_BEG(op)
+#define PROF_END(op,o,n)
+
+#endif // MAD_PROF
+
+// ---------------------------------------------------------------------------o
+
+#endif // MAD_PROF_H
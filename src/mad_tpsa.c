@@ -17,6 +17,7 @@
  o----------------------------------------------------------------------------o
 */
 
+#include <math.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <assert.h>
@@ -24,8 +25,10 @@
 #include "mad_mem.h"
 #include "mad_desc_impl.h"
 
-#ifdef    MAD_CTPSA_IMPL
+#if   defined(MAD_CTPSA_IMPL)
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
@@ -37,7 +40,7 @@ FUN(debug) (const T *t)
 {
   D *d = t->d;
   printf("{ nz=%d lo=%d hi=%d mo=%d | [0]=" FMT " ", t->nz, t->lo, t->hi, t->mo, VAL(t->coef[0]));
-  ord_t hi = MIN3(t->hi, t->mo, t->d->trunc);
+  ord_t hi = MIN3(t->hi, t->mo, desc_trunc(t->d));
   int i = d->ord2idx[MAX(1,t->lo)]; // ord 0 already printed
   for (; i < d->ord2idx[hi+1]; ++i)
     if (t->coef[i])
@@ -77,15 +80,16 @@ ord_t
 
 // --- --- CTORS --------------------------------------------------------------
 
-T*
-FUN(newd) (D *d, ord_t mo)
+static inline T*
+new_tpsa (D *d, ord_t mo, int rgn)
 {
   assert(d);
 
   if (mo == mad_tpsa_default) mo = d->mo;
   else ensure(mo <= d->mo);
 
-  T *t = mad_malloc(sizeof(T) + d->nc * sizeof(NUM));
+  size_t siz = sizeof(T) + d->nc * sizeof(NUM);
+  T *t = rgn ? mad_ralloc(siz) : mad_malloc(siz);
 
   t->d = d;
   t->lo = t->mo = mo;
@@ -93,12 +97,26 @@ FUN(newd) (D *d, ord_t mo)
   return t;
 }
 
+T*
+FUN(newd) (D *d, ord_t mo)
+{
+  return new_tpsa(d,mo,0);
+}
+
 T*
 FUN(new) (const T *t, ord_t mo)
 {
   assert(t);
   if (mo == mad_tpsa_same) mo = t->mo;
-  return FUN(newd)(t->d,mo);
+  return new_tpsa(t->d,mo,0);
+}
+
+T*
+FUN(newr) (const T *t, ord_t mo)
+{
+  assert(t);
+  if (mo == mad_tpsa_same) mo = t->mo;
+  return new_tpsa(t->d,mo,1);
 }
 
 void
@@ -107,8 +125,8 @@ FUN(copy) (const T *t, T *dst)
   assert(t && dst);
   ensure(t->d == dst->d);
   D *d = t->d;
-  if (d->trunc < t->lo) { FUN(clear)(dst); return; }
-  dst->hi = MIN3(t->hi, dst->mo, d->trunc);
+  if (desc_trunc(d) < t->lo) { FUN(clear)(dst); return; }
+  dst->hi = MIN3(t->hi, dst->mo, desc_trunc(d));
   dst->lo = t->lo;
   dst->nz = mad_bit_trunc(t->nz, dst->hi);
 
@@ -137,6 +155,44 @@ FUN(scalar) (T *t, NUM v)
     FUN(clear)(t);
 }
 
+idx_t
+FUN(prune) (T *t, num_t eps)
+{
+  assert(t);
+  D *d = t->d;
+  const idx_t *pi = d->ord2idx;
+  bit_t nz = t->nz;
+  idx_t n = 0;
+
+  // zero negligible coefs, drop the orders left empty
+  for (int o = t->lo; o <= t->hi; ++o) {
+    if (!mad_bit_get(nz,o)) continue;
+    int cnt = 0;
+    for (idx_t i = pi[o]; i < pi[o+1]; ++i)
+      if (t->coef[i]) {
+        if (fabs(t->coef[i]) < eps) t->coef[i] = 0, ++n;
+        else ++cnt;
+      }
+    if (!cnt) nz = mad_bit_clr(nz,o);
+  }
+
+  int ords = 0;
+  for (bit_t b = t->nz & ~nz; b; b &= b-1) ++ords;
+  desc_pstat_add(d, n, ords);
+
+  if (nz != t->nz) {
+    if (!nz) FUN(clear)(t);
+    else {
+      t->nz = nz;
+      t->lo = mad_bit_lowest (nz);
+      t->hi = mad_bit_highest(nz);
+      if (t->lo) t->coef[0] = 0;
+    }
+  }
+
+  return n;
+}
+
 #ifdef MAD_CTPSA_IMPL
 
 void FUN(scalar_r) (T *t, num_t v_re, num_t v_im)
@@ -225,8 +281,8 @@ FUN(set0) (T *t, NUM a, NUM b)
     t->lo = 0;
   }
   else {
-    int n = mad_bit_lowest(t->nz);
     t->nz = mad_bit_clr(t->nz,0);
+    int n = mad_bit_lowest(t->nz);
     t->lo = MIN(n,t->mo);
   }
 }
@@ -330,9 +386,9 @@ FUN(map) (const T *a, T *c, NUM (*f)(NUM v, int i_))
   // TODO: use on the whole range, not just [lo,hi]
 
   D *d = a->d;
-  if (d->trunc < a->lo) { FUN(clear)(c); return c; }
+  if (desc_trunc(d) < a->lo) { FUN(clear)(c); return c; }
 
-  c->hi = MIN3(a->hi, c->mo, d->trunc);
+  c->hi = MIN3(a->hi, c->mo, desc_trunc(d));
   c->lo = a->lo;
   c->nz = mad_bit_trunc(a->nz, c->hi);
 
@@ -350,7 +406,7 @@ FUN(map2) (const T *a, const T *b, T *c, NUM (*f)(NUM va, NUM vb, int i_))
 
   idx_t *pi = a->d->ord2idx;
   if (a->lo > b->lo) { const T* t; SWAP(a,b,t); }
-  ord_t c_hi = MIN3(MAX(a->hi,b->hi),c->mo,c->d->trunc),
+  ord_t c_hi = MIN3(MAX(a->hi,b->hi),c->mo,desc_trunc(c->d)),
         c_lo = a->lo;
 
   NUM va, vb;
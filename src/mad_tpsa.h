@@ -24,6 +24,12 @@
  
   Information:
   - parameters ending with an underscope can be null.
+  - mad_tpsa_newr allocates the GTPSA in the current region of the thread if
+    any (see mad_mem.h), mad_tpsa_del can still be used and is a no-op then.
+  - mad_tpsa_prune zeroes the coefficients with |c| < eps, drops the orders
+    left empty and returns the number of coefficients zeroed. It is applied
+    to the results of mul and compose if the descriptor has a threshold
+    (see mad_desc_geps).
 
   Errors:
   - TODO
@@ -39,6 +45,7 @@
 // --- types -----------------------------------------------------------------o
 
 struct ctpsa;
+struct ftpsa;
 typedef struct tpsa tpsa_t;
 
 // --- globals ---------------------------------------------------------------o
@@ -52,6 +59,7 @@ extern       int   mad_tpsa_strict;
 // ctors, dtor
 tpsa_t* mad_tpsa_newd    (desc_t *d, ord_t mo); // if mo > d_mo, mo = d_mo
 tpsa_t* mad_tpsa_new     (const tpsa_t *t, ord_t mo);
+tpsa_t* mad_tpsa_newr    (const tpsa_t *t, ord_t mo); // in current region
 void    mad_tpsa_del     (      tpsa_t *t);
 
 // introspection
@@ -63,9 +71,11 @@ ord_t   mad_tpsa_ordv    (const tpsa_t *t1, const tpsa_t *t2, ...);  // max orde
 void    mad_tpsa_copy    (const tpsa_t *t, tpsa_t *dst);
 void    mad_tpsa_clear   (      tpsa_t *t);
 void    mad_tpsa_scalar  (      tpsa_t *t, num_t v);
+idx_t   mad_tpsa_prune   (      tpsa_t *t, num_t eps); // zero |coef| < eps
 
 // conversion
 void    mad_tpsa_complex (const tpsa_t *re_, const tpsa_t *im_, struct ctpsa *dst);
+void    mad_tpsa_float   (const tpsa_t *t, struct ftpsa *dst);
 
 // indexing / monomials
 int     mad_tpsa_mono    (const tpsa_t *t, int n,       ord_t m_[], idx_t i);
@@ -22,10 +22,13 @@
 #include <assert.h>
 
 #include "mad_log.h"
+#include "mad_prof.h"
 #include "mad_desc_impl.h"
 
-#ifdef    MAD_CTPSA_IMPL
+#if   defined(MAD_CTPSA_IMPL)
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
@@ -59,22 +62,44 @@ check_compose(int sa, const T *ma[], int sb, const T *mb[], int sc, T *mc[])
 #endif
 #include "mad_tpsa_comp_s.tc"
 
+static inline idx_t
+map_coefs(int sc, T *mc[sc])  // for profiling
+{
+  idx_t n = 0;
+  for (int i = 0; i < sc; ++i)
+    n += mc[i]->d->ord2idx[mc[i]->hi+1];
+  return n;
+}
+
 // --- PUBLIC FUNCTIONS -------------------------------------------------------
 
 void
 FUN(compose) (int sa, const T *ma[], int sb, const T *mb[], int sc, T *mc[])
 {
   check_compose(sa, ma, sb, mb, sc, mc);
+  PROF_BEG(prof_compose);
 
   #ifdef _OPENMP
   ord_t highest = 0;
   for (int i = 0; i < sa; ++i)
     if (ma[i]->hi > highest) highest = ma[i]->hi;
 
-  if (highest >= 6)
+  if (highest >= 6 && ma[0]->d->nmv == ma[0]->d->nv) { // parallel is knobs unaware
+    PROF_BEG(prof_compose_par);
     compose_parallel(sa,ma,mb,mc);
+    PROF_END(prof_compose_par, desc_trunc(ma[0]->d), map_coefs(sc,mc));
+  }
   else
   #endif // _OPENMP
+  {
+    PROF_BEG(prof_compose_ser);
+    compose_serial(sa,ma,mb,mc);
+    PROF_END(prof_compose_ser, desc_trunc(ma[0]->d), map_coefs(sc,mc));
+  }
+
+  D *d = ma[0]->d;
+  if (d->eps > 0)
+    for (int i = 0; i < sc; ++i) FUN(prune)(mc[i], d->eps);
 
-  compose_serial(sa,ma,mb,mc);
+  PROF_END(prof_compose, desc_trunc(d), map_coefs(sc,mc));
 }
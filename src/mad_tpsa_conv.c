@@ -25,6 +25,7 @@
 #define   MAD_TPSA_NOHELPER
 #include "mad_tpsa_impl.h"
 #include "mad_ctpsa_impl.h"
+#include "mad_ftpsa_impl.h"
 #undef    MAD_TPSA_NOHELPER
 
 void
@@ -34,10 +35,10 @@ mad_ctpsa_real (const ctpsa_t *t, tpsa_t *dst)
   ensure(t->d == dst->d);
 
   desc_t *d = t->d;
-  if (d->trunc < t->lo) { mad_tpsa_clear(dst); return; }
+  if (desc_trunc(d) < t->lo) { mad_tpsa_clear(dst); return; }
 
   dst->lo = t->lo;
-  dst->hi = MIN3(t->hi, dst->mo, d->trunc);
+  dst->hi = MIN3(t->hi, dst->mo, desc_trunc(d));
   dst->nz = mad_bit_trunc(t->nz, dst->hi);
 
   for (int i = d->ord2idx[dst->lo]; i < d->ord2idx[dst->hi+1]; ++i)
@@ -51,10 +52,10 @@ mad_ctpsa_imag (const ctpsa_t *t, tpsa_t *dst)
   ensure(t->d == dst->d);
 
   desc_t *d = t->d;
-  if (d->trunc < t->lo) { mad_tpsa_clear(dst); return; }
+  if (desc_trunc(d) < t->lo) { mad_tpsa_clear(dst); return; }
 
   dst->lo = t->lo;
-  dst->hi = MIN3(t->hi, dst->mo, d->trunc);
+  dst->hi = MIN3(t->hi, dst->mo, desc_trunc(d));
   dst->nz = mad_bit_trunc(t->nz, dst->hi);
 
   for (int i = d->ord2idx[dst->lo]; i < d->ord2idx[dst->hi+1]; ++i)
@@ -70,11 +71,11 @@ mad_tpsa_complex (const tpsa_t *re_, const tpsa_t *im_, ctpsa_t *dst)
   ensure(re->d == dst->d && im->d == dst->d);
 
   D *d = dst->d;
-  if (d->trunc < MIN(re->lo, im->lo)) { mad_ctpsa_clear(dst); return; }
+  if (desc_trunc(d) < MIN(re->lo, im->lo)) { mad_ctpsa_clear(dst); return; }
 
   ord_t hi = MAX(re->hi, im->hi);
   dst->lo  = MIN(re->lo, im->lo);
-  dst->hi  = MIN3(hi, dst->mo, d->trunc);
+  dst->hi  = MIN3(hi, dst->mo, desc_trunc(d));
   dst->nz  = mad_bit_trunc(mad_bit_add(re->nz, im->nz), dst->hi);
 
   for (int i = d->ord2idx[dst->lo]; i < d->ord2idx[dst->hi+1]; ++i) {
@@ -86,3 +87,36 @@ mad_tpsa_complex (const tpsa_t *re_, const tpsa_t *im_, ctpsa_t *dst)
   }
 }
 
+void
+mad_tpsa_float (const tpsa_t *t, ftpsa_t *dst)
+{
+  assert(t && dst);
+  ensure(t->d == dst->d);
+
+  desc_t *d = t->d;
+  if (desc_trunc(d) < t->lo) { mad_ftpsa_clear(dst); return; }
+
+  dst->lo = t->lo;
+  dst->hi = MIN3(t->hi, dst->mo, desc_trunc(d));
+  dst->nz = mad_bit_trunc(t->nz, dst->hi);
+
+  for (int i = d->ord2idx[dst->lo]; i < d->ord2idx[dst->hi+1]; ++i)
+    dst->coef[i] = (fnum_t)t->coef[i];
+}
+
+void
+mad_ftpsa_double (const ftpsa_t *t, tpsa_t *dst)
+{
+  assert(t && dst);
+  ensure(t->d == dst->d);
+
+  desc_t *d = t->d;
+  if (desc_trunc(d) < t->lo) { mad_tpsa_clear(dst); return; }
+
+  dst->lo = t->lo;
+  dst->hi = MIN3(t->hi, dst->mo, desc_trunc(d));
+  dst->nz = mad_bit_trunc(t->nz, dst->hi);
+
+  for (int i = d->ord2idx[dst->lo]; i < d->ord2idx[dst->hi+1]; ++i)
+    dst->coef[i] = t->coef[i];
+}
@@ -22,10 +22,13 @@
 
 #include "mad_cst.h"
 #include "mad_log.h"
+#include "mad_prof.h"
 #include "mad_desc_impl.h"
 
-#ifdef    MAD_CTPSA_IMPL
+#if   defined(MAD_CTPSA_IMPL)
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
@@ -41,6 +44,7 @@ fixed_point_iteration(const T *a, T *c, int iter, NUM expansion_coef[iter+1])
 {
   assert(a && c && expansion_coef);
   assert(iter >= 1); // ord 0 treated outside
+  PROF_BEG(prof_fun);
 
   T *acp = a->d->PFX(t[2]);
   if (iter >=2)      // save copy before scale, to deal with aliasing
@@ -63,6 +67,7 @@ fixed_point_iteration(const T *a, T *c, int iter, NUM expansion_coef[iter+1])
       SWAP(pow,tmp,t);
     }
   }
+  PROF_END(prof_fun, iter, c->d->ord2idx[c->hi+1]);
 }
 
 static inline void
@@ -70,6 +75,7 @@ sincos_fixed_point(const T *a, T *s, T *c, int iter_s, NUM sin_coef[iter_s+1], i
 {
   assert(a && s && c && sin_coef && cos_coef);
   assert(iter_s >= 1 && iter_c >= 1);  // ord 0 treated outside
+  PROF_BEG(prof_fun);
 
   int max_iter = MAX(iter_s,iter_c);
   T *acp = a->d->PFX(t[2]);
@@ -94,6 +100,7 @@ sincos_fixed_point(const T *a, T *s, T *c, int iter_s, NUM sin_coef[iter_s+1], i
       SWAP(pow,tmp,t);
     }
   }
+  PROF_END(prof_fun, max_iter, s->d->ord2idx[s->hi+1] + c->d->ord2idx[c->hi+1]);
 }
 
 // --- PUBLIC FUNCTIONS -------------------------------------------------------
@@ -115,7 +122,7 @@ FUN(inv) (const T *a, NUM v, T *c) // v/a
   ensure(a->d == c->d);
   ensure(a->coef[0] != 0);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to || a->hi == 0) { FUN(scalar)(c, v/a->coef[0]); return; }
 
   NUM expansion_coef[to+1], a0 = a->coef[0];
@@ -136,7 +143,7 @@ FUN(sqrt) (const T *a, T *c)
 
   if (a->coef[0] == 0) { FUN(clear)(c); return; }
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to || a->hi == 0) { FUN(scalar)(c, sqrt(a->coef[0])); return; }
 
   NUM expansion_coef[to+1], a0 = a->coef[0];
@@ -154,7 +161,7 @@ FUN(invsqrt) (const T *a, NUM v, T *c)  // v/sqrt(a)
   ensure(a->d == c->d);
   ensure(a->coef[0] SELECT(> 0, != 0));
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to || a->hi == 0) { FUN(scalar)(c, v/sqrt(a->coef[0])); return; }
 
   NUM expansion_coef[to+1], a0 = a->coef[0];
@@ -173,7 +180,7 @@ FUN(exp) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to || a->hi == 0) { FUN(scalar)(c, exp(a->coef[0])); return; }
 
   NUM expansion_coef[to+1], a0 = a->coef[0];
@@ -192,7 +199,7 @@ FUN(log) (const T *a, T *c)
   ensure(a->d == c->d);
   ensure(a->coef[0] SELECT(> 0, != 0));
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to || a->hi == 0) { FUN(scalar)(c, log(a->coef[0])); return; }
 
   NUM expansion_coef[to+1], a0 = a->coef[0];
@@ -211,7 +218,7 @@ FUN(sin) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to || a->hi == 0) { FUN(scalar)(c, sin(a->coef[0])); return; }
 
   NUM expansion_coef[to+1], a0 = a->coef[0];
@@ -230,7 +237,7 @@ FUN(cos) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to || a->hi == 0) { FUN(scalar)(c, cos(a->coef[0])); return; }
 
   NUM expansion_coef[to+1], a0 = a->coef[0];
@@ -248,8 +255,8 @@ FUN(sincos) (const T *a, T *s, T *c)
   assert(a && s && c);
   ensure(a->d == s->d && a->d == c->d);
 
-  ord_t sto = MIN(s->mo,s->d->trunc),
-        cto = MIN(c->mo,c->d->trunc);
+  ord_t sto = MIN(s->mo,desc_trunc(s->d)),
+        cto = MIN(c->mo,desc_trunc(c->d));
 
   NUM s_a0 = sin(a->coef[0]), c_a0 = cos(a->coef[0]);
   if (a->hi == 0) {
@@ -285,7 +292,7 @@ FUN(sinh) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to || a->hi == 0) { FUN(scalar)(c, sinh(a->coef[0])); return; }
 
   NUM expansion_coef[to+1], a0 = a->coef[0];
@@ -303,7 +310,7 @@ FUN(cosh) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to || a->hi == 0) { FUN(scalar)(c, cosh(a->coef[0])); return; }
 
   NUM expansion_coef[to+1], a0 = a->coef[0];
@@ -321,8 +328,8 @@ FUN(sincosh) (const T *a, T *sh, T *ch)
   assert(a && sh && ch);
   ensure(a->d == sh->d && a->d == ch->d);
 
-  ord_t sto = MIN(sh->mo,sh->d->trunc),
-        cto = MIN(ch->mo,ch->d->trunc);
+  ord_t sto = MIN(sh->mo,desc_trunc(sh->d)),
+        cto = MIN(ch->mo,desc_trunc(ch->d));
 
   NUM s_a0 = sinh(a->coef[0]), c_a0 = cosh(a->coef[0]);  // TODO: use sincos ?
   if (a->hi == 0) {
@@ -360,7 +367,7 @@ FUN(sirx) (const T *a, T *c)
   ensure(a->d == c->d);
   ensure(a->coef[0] == 0);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to) { FUN(scalar)(c, 1); return; }
 
   NUM expansion_coef[to+1];
@@ -379,7 +386,7 @@ FUN(corx) (const T *a, T *c)
   ensure(a->d == c->d);
   ensure(a->coef[0] == 0);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to) { FUN(scalar)(c, 1); return; }
 
   NUM expansion_coef[to+1];
@@ -398,7 +405,7 @@ FUN(sinc) (const T *a, T *c)
   ensure(a->d == c->d);
   ensure(a->coef[0] == 0);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   if (!to) { FUN(scalar)(c, 1); return; }
 
   NUM expansion_coef[to+1];
@@ -420,7 +427,7 @@ FUN(tan) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
 
   if (!to || a->hi == 0) { FUN(scalar)(c, tan(a->coef[0])); return; }
   if (to > 5) {
@@ -453,7 +460,7 @@ FUN(cot) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
 
   if (!to || a->hi == 0) { FUN(scalar)(c, tan(M_PI_2 - a->coef[0])); return; }
   if (to > 5) {
@@ -486,7 +493,7 @@ FUN(asin) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -510,7 +517,7 @@ FUN(acos) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -534,7 +541,7 @@ FUN(atan) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -557,7 +564,7 @@ FUN(acot) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -580,7 +587,7 @@ FUN(tanh) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -605,7 +612,7 @@ FUN(coth) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -630,7 +637,7 @@ FUN(asinh) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -654,7 +661,7 @@ FUN(acosh) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -678,7 +685,7 @@ FUN(atanh) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -701,7 +708,7 @@ FUN(acoth) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -725,7 +732,7 @@ FUN(erf) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  ord_t to = MIN(c->mo,c->d->trunc);
+  ord_t to = MIN(c->mo,desc_trunc(c->d));
   ensure(to <= 5);
 
   NUM expansion_coef[MANUAL_EXPANSION_ORD+1], a0 = a->coef[0];
@@ -24,9 +24,12 @@
 #include "mad_mem.h"
 #include "mad_desc_impl.h"
 
-#ifdef    MAD_CTPSA_IMPL
+#if   defined(MAD_CTPSA_IMPL)
 #include "mad_ctpsa_impl.h"
 #define  SPC "                     "
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
+#define  SPC
 #else
 #include "mad_tpsa_impl.h"
 #define  SPC
@@ -45,7 +48,7 @@ read_ords(int n, ord_t ords[n], FILE *stream)
 }
 
 static inline void
-print_ords(int n, ord_t ords[n], FILE *stream)
+print_ords(int n, const ord_t ords[n], FILE *stream)
 {
   assert(ords && stream);
   for (int i = 0; i+1 < n; i += 2)
@@ -76,7 +79,7 @@ scan_var_names(FILE *stream, int nmv, char *buf)
 
 // --- PUBLIC FUNCTIONS -------------------------------------------------------
 
-#ifdef MAD_CTPSA_IMPL
+#if defined(MAD_CTPSA_IMPL) || defined(MAD_FTPSA_IMPL)
 
 extern D* mad_tpsa_scan_hdr(FILE*);
 
@@ -99,8 +102,8 @@ FUN(scan_hdr) (FILE *stream_)
   int nmv, nk = 0, read_cnt = 0;
   D *d = NULL;
 
-  // discard leading white space and the name (which is 10 chars and comma)
-  read_cnt = fscanf(stream_, " %*11c");
+  // discard leading white space and the name (up to 10 chars and comma)
+  read_cnt = fscanf(stream_, " %*10[^,],");
 
   // 1st line
   read_cnt = fscanf(stream_, " NO =%5hhu, NV =%5d, KO =%5hhu, NK =%5d",
@@ -110,6 +113,7 @@ FUN(scan_hdr) (FILE *stream_)
   ord_t var_ords[nmv];
   if (read_cnt == 4) {                      // GTPSA -- process rest of lines
     ord_t map_ords[nmv], knb_ords[nk ? nk : 1];
+    knb_ords[0] = 0;                        // no knobs
     read_cnt = fscanf(stream_, " MAP ORDS: ");
     ensure(!feof(stream_) && !ferror(stream_));
     read_ords(nmv,map_ords,stream_);
@@ -145,7 +149,7 @@ FUN(scan_hdr) (FILE *stream_)
   return d;
 }
 
-#endif // !MAD_CTPSA_IMPL
+#endif // !MAD_CTPSA_IMPL && !MAD_FTPSA_IMPL
 
 void
 FUN(scan_coef) (T *t, FILE *stream_)
@@ -158,7 +162,9 @@ FUN(scan_coef) (T *t, FILE *stream_)
   ord_t o, ords[nv];
   FUN(clear)(t);
 
-#ifndef MAD_CTPSA_IMPL
+#if   defined(MAD_FTPSA_IMPL)
+  while ((read_cnt = fscanf(stream_, "%*d %G %hhu", &c, &o)) == 2) {
+#elif !defined(MAD_CTPSA_IMPL)
   while ((read_cnt = fscanf(stream_, "%*d %lG %hhu", &c, &o)) == 2) {
 #else
   while ((read_cnt = fscanf(stream_, "%*d %lG%lGi %hhu", (num_t*)&c, (num_t*)&c+1, &o)) == 2) {
@@ -214,6 +220,7 @@ FUN(print) (const T *t, str_t name_, FILE *stream_)
 
   fprintf(stream_, "\n    I  COEFFICIENT         " SPC " ORDER   EXPONENTS");
   int idx = 1;
+  ord_t m[d->nv];
   for (int c = 0; c < d->nc; ++c)
     if (mad_bit_get(t->nz,d->ords[c]) && fabs(t->coef[c]) > 1e-10) {
 
@@ -223,7 +230,7 @@ FUN(print) (const T *t, str_t name_, FILE *stream_)
       fprintf(stream_, "\n%6d  %21.14lE%+21.14lEi%5hhu   ", idx, VAL(t->coef[c]), d->ords[c]);      
 #endif
 
-      print_ords(d->nv, d->To[c], stream_);
+      print_ords(d->nv, desc_mono(d,c,m), stream_);
       idx++;
     }
   fprintf(stream_, "\n\n");
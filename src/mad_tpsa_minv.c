@@ -20,16 +20,26 @@
 #include <assert.h>
 
 #include "mad_mem.h"
+#include "mad_prof.h"
 #include "mad_vec.h"
 #include "mad_mat.h"
 #include "mad_desc_impl.h"
 
-#ifdef    MAD_CTPSA_IMPL
+#if   defined(MAD_CTPSA_IMPL)
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
 
+// linear algebra is done in double precision for ftpsa
+#ifdef    MAD_FTPSA_IMPL
+#define MNUM num_t
+#else
+#define MNUM NUM
+#endif
+
 // --- LOCAL FUNCTIONS --------------------------------------------------------
 
 static inline void
@@ -114,10 +124,10 @@ static void
 split_and_inv(const D *d, const T *ma[], T *lin_inv[], T *nonlin[])
 {
   int nv = d->nv, cv = d->nmv, nk = nv - cv; // #vars, #canonical vars, #knobs
-  mad_alloc_tmp(NUM, mat_var , cv*cv); // canonical vars
-  mad_alloc_tmp(NUM, mat_vari, cv*cv); // inverse of vars
-  mad_alloc_tmp(NUM, mat_knb , cv*nk); // knobs
-  mad_alloc_tmp(NUM, mat_knbi, cv*nk); // 'inverse' of knobs
+  mad_alloc_tmp(MNUM, mat_var , cv*cv); // canonical vars
+  mad_alloc_tmp(MNUM, mat_vari, cv*cv); // inverse of vars
+  mad_alloc_tmp(MNUM, mat_knb , cv*nk); // knobs
+  mad_alloc_tmp(MNUM, mat_knbi, cv*nk); // 'inverse' of knobs
 
   // split linear, (-1 * nonlinear)
   for (int i = 0; i < cv; ++i) {
@@ -137,7 +147,7 @@ split_and_inv(const D *d, const T *ma[], T *lin_inv[], T *nonlin[])
   }
 
   // invert linear part: mat_vari = mat_var^-1
-# ifndef MAD_CTPSA_IMPL
+# ifndef MAD_CTPSA_IMPL // real and float
   mad_mat_invn(mat_var, 1, mat_vari, cv, cv, -1);
   if (nk != 0) {
     // mat_knbi = - mat_vari * mat_knb
@@ -176,6 +186,7 @@ FUN(minv) (int sa, const T *ma[sa], int sc, T *mc[sc])
   check_minv(sa,ma,sc,mc);
   for (int i = 0; i < sa; ++i)
     ensure(mad_bit_get(ma[i]->nz,1));
+  PROF_BEG(prof_minv);
 
   D *d = ma[0]->d;
   T *lin_inv[sa], *nonlin[sa], *tmp[sa];
@@ -193,8 +204,10 @@ FUN(minv) (int sa, const T *ma[sa], int sc, T *mc[sc])
   for (int i = 0; i < sa; ++i)
     FUN(copy)(lin_inv[i], mc[i]);
 
-  for (int o = 2; o <= d->mo; ++o) {
-    d->trunc = o;
+  // orders are raised in the context of the calling thread, up to its trunc
+  ord_t to = desc_trunc(d), ctx = desc_tctx(d, 0);
+  for (int o = 2; o <= to; ++o) {
+    desc_tctx(d, o+1);
     FUN(compose)(sa, (const T**)nonlin,  sa, (const T**)mc,  sa, tmp);
 
     for (int v = 0; v < sa; ++v)
@@ -202,6 +215,7 @@ FUN(minv) (int sa, const T *ma[sa], int sc, T *mc[sc])
 
     FUN(compose)(sa, (const T**)lin_inv, sa, (const T**)tmp, sa, mc);
   }
+  desc_tctx(d, ctx);
 
   // cleanup
   for (int i = 0; i < sa; ++i) {
@@ -209,6 +223,7 @@ FUN(minv) (int sa, const T *ma[sa], int sc, T *mc[sc])
     FUN(del)(nonlin[i]);
     FUN(del)(tmp[i]);
   }
+  PROF_END(prof_minv, d->mo, sc*d->ord2idx[d->mo+1]);
 }
 
 void
@@ -219,6 +234,7 @@ FUN(pminv) (int sa, const T *ma[sa], int sc, T *mc[sc], int row_select[sa])
   for (int i = 0; i < sa; ++i)
     if (row_select[i])
       ensure(mad_bit_get(ma[i]->nz,1));
+  PROF_BEG(prof_pminv);
 
   D *d = ma[0]->d;
   // split input map into rows that are inverted and rows that are not
@@ -250,5 +266,6 @@ FUN(pminv) (int sa, const T *ma[sa], int sc, T *mc[sc], int row_select[sa])
     FUN(del)(mUnused[i]);
     FUN(del)(mInv[i]);
   }
+  PROF_END(prof_pminv, d->mo, sc*d->ord2idx[d->mo+1]);
 }
 
@@ -21,10 +21,13 @@
 #include <assert.h>
 
 #include "mad_log.h"
+#include "mad_prof.h"
 #include "mad_desc_impl.h"
 
-#ifdef    MAD_CTPSA_IMPL
+#if   defined(MAD_CTPSA_IMPL)
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
@@ -137,6 +140,7 @@ hpoly_mul(const T *a, const T *b, T *c, const ord_t *ocs, bit_t *cnz, int in_par
 static inline void
 hpoly_mul_par(const T *a, const T *b, T *c)
 {
+  PROF_BEG(prof_mul_par);
   int nb_threads = omp_get_num_procs();
   bit_t c_nzs[nb_threads];
   for (int t = 0; t < nb_threads; ++t)
@@ -148,22 +152,26 @@ hpoly_mul_par(const T *a, const T *b, T *c)
 
   for (int t = 0; t < nb_threads; ++t)
     c->nz |= c_nzs[t];
+  PROF_END(prof_mul_par, c->hi, c->d->ord2idx[c->hi+1]);
 }
 #endif
 
 static inline void
 hpoly_mul_ser(const T *a, const T *b, T *c)
 {
+  PROF_BEG(prof_mul_ser);
   hpoly_mul(a,b,c,c->d->ocs[0],&c->nz,0);
+  PROF_END(prof_mul_ser, c->hi, c->d->ord2idx[c->hi+1]);
 }
 
 static inline int
 der_coef(idx_t ia, idx_t di, ord_t der_ord, const D* d)
 {
   if (der_ord == 1) // der against var
-    return d->To[ia][di-1];
+    return desc_mono_var(d, ia, di-1);
 
-  const ord_t *msrc = d->To[ia], *mder = d->To[di];
+  ord_t ms[d->nv], md[d->nv];
+  const ord_t *msrc = desc_mono(d, ia, ms), *mder = desc_mono(d, di, md);
   if (!mad_mono_leq(d->nv,mder,msrc))
     return 0;
 
@@ -233,7 +241,7 @@ hpoly_der(const T *a, idx_t idx, ord_t ord, T *c)
   const NUM *ca = a->coef;
         NUM *cc;
 
-  c->hi = MIN3(c->mo, d->trunc, a->hi-ord);  // initial guess, readjust based on nz
+  c->hi = MIN3(c->mo, desc_trunc(d), a->hi-ord);  // initial guess, readjust based on nz
   for (int oc = 1; oc <= c->hi; ++oc)
     if (mad_bit_get(a->nz,oc+ord)) {
       cc = c->coef + pi[oc];
@@ -259,7 +267,7 @@ FUN(abs) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  c->hi = MIN3(a->hi, c->mo, c->d->trunc);
+  c->hi = MIN3(a->hi, c->mo, desc_trunc(c->d));
   c->lo = a->lo;
   c->nz = mad_bit_trunc(a->nz,c->hi);
 
@@ -277,7 +285,7 @@ FUN(arg) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  c->hi = MIN3(a->hi, c->mo, c->d->trunc);
+  c->hi = MIN3(a->hi, c->mo, desc_trunc(c->d));
   c->lo = a->lo;
   c->nz = mad_bit_trunc(a->nz,c->hi);
 
@@ -292,7 +300,7 @@ FUN(conj) (const T *a, T *c)
   assert(a && c);
   ensure(a->d == c->d);
 
-  c->hi = MIN3(a->hi, c->mo, c->d->trunc);
+  c->hi = MIN3(a->hi, c->mo, desc_trunc(c->d));
   c->lo = a->lo;
   c->nz = mad_bit_trunc(a->nz,c->hi);
 
@@ -313,8 +321,8 @@ FUN(nrm1) (const T *a, const T *b_)
     ensure(a->d == b_->d);
     if (a->lo > b_->lo) { const T *t; SWAP(a,b_,t); }
 
-    idx_t start_a = pi[a ->lo], end_a = pi[MIN(a ->hi,a ->d->trunc)+1],
-          start_b = pi[b_->lo], end_b = pi[MIN(b_->hi,b_->d->trunc)+1];
+    idx_t start_a = pi[a ->lo], end_a = pi[MIN(a ->hi,desc_trunc(a ->d))+1],
+          start_b = pi[b_->lo], end_b = pi[MIN(b_->hi,desc_trunc(b_->d))+1];
     idx_t i;
     for (i = start_a; i < MIN(end_a,start_b); ++i) norm += fabs(a->coef[i]);
     for (i = start_b; i < MIN(end_a,end_b)  ; ++i) norm += fabs(a->coef[i] - b_->coef[i]);
@@ -322,7 +330,7 @@ FUN(nrm1) (const T *a, const T *b_)
     for (           ; i <     end_b         ; ++i) norm += fabs(b_->coef[i]);
   }
   else {
-    ord_t hi = MIN(a->hi, a->d->trunc);
+    ord_t hi = MIN(a->hi, desc_trunc(a->d));
     for (int o = a->lo; o <= hi; ++o)
       if (mad_bit_get(a->nz,o)) {
         for (int i = pi[o]; i < pi[o+1]; ++i)
@@ -342,8 +350,8 @@ FUN(nrm2) (const T *a, const T *b_)
     ensure(a->d == b_->d);
     if (a->lo > b_->lo) { const T* t; SWAP(a,b_,t); }
 
-    idx_t start_a = pi[a ->lo], end_a = pi[MIN(a ->hi,a ->d->trunc)+1],
-          start_b = pi[b_->lo], end_b = pi[MIN(b_->hi,b_->d->trunc)+1];
+    idx_t start_a = pi[a ->lo], end_a = pi[MIN(a ->hi,desc_trunc(a ->d))+1],
+          start_b = pi[b_->lo], end_b = pi[MIN(b_->hi,desc_trunc(b_->d))+1];
     idx_t i;
     for (i = start_a; i < MIN(end_a,start_b); ++i) norm +=  a->coef[i]              *  a->coef[i];
     for (i = start_b; i < MIN(end_a,end_b)  ; ++i) norm += (a->coef[i]-b_->coef[i]) * (a->coef[i]-b_->coef[i]);
@@ -351,7 +359,7 @@ FUN(nrm2) (const T *a, const T *b_)
     for (           ; i <     end_b         ; ++i) norm +=  b_->coef[i]             *  b_->coef[i];
   }
   else {
-    ord_t hi = MIN(a->hi, a->d->trunc);
+    ord_t hi = MIN(a->hi, desc_trunc(a->d));
     for (int o = a->lo; o <= hi; ++o)
       if (mad_bit_get(a->nz,o)) {
         for (int i = pi[o]; i < pi[o+1]; ++i)
@@ -372,7 +380,7 @@ FUN(der) (const T *a, T *c, int var)
   FUN(scalar)(c,FUN(geti)(a,var));  // TODO: what if alpha[var] == 0 ?
 
   D *d = c->d;
-  c->hi = MIN3(c->mo, d->trunc, a->hi-1);
+  c->hi = MIN3(c->mo, desc_trunc(d), a->hi-1);
   c->lo = a->lo ? a->lo-1 : 0;  // initial guess, readjusted after computation
 
   idx_t *pi = d->ord2idx;
@@ -423,7 +431,7 @@ FUN(scl) (const T *a, NUM v, T *c)
 
   D *d = a->d;
   c->lo = a->lo;
-  c->hi = MIN3(a->hi, c->mo, d->trunc);
+  c->hi = MIN3(a->hi, c->mo, desc_trunc(d));
   c->nz = mad_bit_trunc(a->nz,c->hi);
   for (int i = d->ord2idx[c->lo]; i < d->ord2idx[c->hi+1]; ++i)
     c->coef[i] = v * a->coef[i];
@@ -470,7 +478,7 @@ FUN(acc) (const T *a, NUM v, T *c)
   D *d = c->d;
   const NUM *ca = a->coef;
         NUM *cc = c->coef;
-  ord_t new_hi = MIN3(a->hi,c->mo,d->trunc);
+  ord_t new_hi = MIN3(a->hi,c->mo,desc_trunc(d));
   ord_t new_lo = MIN(a->lo,c->lo);
 
   for (int i = d->ord2idx[new_lo ]; i < d->ord2idx[c->lo   ]; ++i) cc[i] = 0;
@@ -494,7 +502,7 @@ FUN(acc) (const T *a, NUM v, T *c)
   if (a->lo > b->lo) SWAP(a,b,t);
 
   ord_t   hi = MAX(a->hi,b->hi);
-  ord_t c_hi = MIN3(hi, c->mo, c->d->trunc);
+  ord_t c_hi = MIN3(hi, c->mo, desc_trunc(c->d));
   if (t) TPSA_LINOP(v*,+  );  // c->coef[i] = v*a->coef[i] +   c->coef[i];
   else   TPSA_LINOP(  ,+v*);  // c->coef[i] =   c->coef[i] + v*a->coef[i];
   c->lo = a->lo; // a->lo <= b->lo  (because of swap)
@@ -513,7 +521,7 @@ FUN(add) (const T *a, const T *b, T *c)
   if (a->lo > b->lo) SWAP(a,b,t);
 
   ord_t   hi = MAX(a->hi,b->hi);
-  ord_t c_hi = MIN3(hi, c->mo, c->d->trunc);
+  ord_t c_hi = MIN3(hi, c->mo, desc_trunc(c->d));
   TPSA_LINOP( ,+);  // c->coef[i] = a->coef[i] + b->coef[i];
   c->lo = a->lo;    // a->lo <= b->lo  (because of swap)
   c->hi = c_hi;
@@ -530,7 +538,7 @@ FUN(sub) (const T *a, const T *b, T *c)
   if (a->lo > b->lo) SWAP(a,b,t);
 
   ord_t   hi = MAX(a->hi,b->hi);
-  ord_t c_hi = MIN3(hi, c->mo, c->d->trunc);
+  ord_t c_hi = MIN3(hi, c->mo, desc_trunc(c->d));
   if (t) TPSA_LINOP(-,+); // c->coef[i] = - a->coef[i] + b->coef[i];
   else   TPSA_LINOP( ,-); // c->coef[i] =   a->coef[i] - b->coef[i];
   c->lo = a->lo; // a->lo <= b->lo  (because of swap)
@@ -543,12 +551,13 @@ FUN(mul) (const T *a, const T *b, T *r)
 {
   assert(a && b && r);
   ensure(a->d == b->d && a->d == r->d);
+  PROF_BEG(prof_mul);
 
   T *c = (a == r || b == r) ? r->d->PFX(t[0]) : r;
 
   D *d = a->d;
   c->lo = a->lo + b->lo;
-  c->hi = MIN3(a->hi + b->hi, c->mo, d->trunc);
+  c->hi = MIN3(a->hi + b->hi, c->mo, desc_trunc(d));
 
   // empty
   if (c->lo > c->hi) { FUN(clear)(c); goto ret; }
@@ -603,7 +612,9 @@ FUN(mul) (const T *a, const T *b, T *r)
 
 ret:
   assert(a != c && b != c);
+  if (d->eps > 0) FUN(prune)(c, d->eps);
   if (c != r) FUN(copy)(c,r);
+  PROF_END(prof_mul, r->hi, d->ord2idx[r->hi+1]);
 }
 
 void
@@ -675,7 +686,7 @@ FUN(axpbypc) (NUM c1, const T *a, NUM c2, const T *b, NUM c3, T *c)
     NUM n;    SWAP(c1,c2,n);
   }
   ord_t   hi = MAX(a->hi,b->hi);
-  ord_t c_hi = MIN3(hi, c->mo, c->d->trunc);  // TODO: optimise c_hi == 0 ?
+  ord_t c_hi = MIN3(hi, c->mo, desc_trunc(c->d));  // TODO: optimise c_hi == 0 ?
   TPSA_LINOP(c1 *, + c2 *);  // c->coef[i] = c1 * a->coef[i] + c2 * b->coef[i];
 
   c->lo = a->lo;    // a->lo <= b->lo  (because of swap)
@@ -741,7 +752,7 @@ FUN(poisson) (const T *a, const T *b, T *c, int n)
 
   T *is[4];
   for (int i = 0; i < 4; ++i)
-    is[i] = FUN(new)(a, a->d->trunc);
+    is[i] = FUN(new)(a, desc_trunc(a->d));
 
   for (int i = 1; i <= n; ++i) {
     FUN(der)(a, is[0], 2*i - 1);
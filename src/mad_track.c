@@ -1,6 +1,10 @@
+#include <math.h>
+#include <time.h>
 #include <assert.h>
 
+#include "mad_log.h"
 #include "mad_tpsa.h"
+#include "mad_track.h"
 
 // TODO: update the maps with the final Lua versions!
 
@@ -20,8 +24,8 @@ mad_track_drift(T * restrict m[], num_t L, num_t B, num_t E)
   assert(x ); assert(y ); assert(s ); 
   assert(px); assert(py); assert(ps);
 
-  T *t1 = mad_tpsa_new(x, mad_tpsa_default);
-  T *t2 = mad_tpsa_new(s, mad_tpsa_same   );
+  T *t1 = mad_tpsa_newr(x, mad_tpsa_default);
+  T *t2 = mad_tpsa_newr(s, mad_tpsa_same   );
 
   mad_tpsa_ax2pby2pcz2(1,ps, -1,px, -1,py, t1); // ps^2 - px^2 - py^2
   mad_tpsa_axpbypc(2/B,ps, 1,t1, 1, t1);        // 1 + 2/B*m.ps + ps^2 - px^2 - py^2
@@ -56,14 +60,14 @@ mad_track_kick(T * restrict m[], num_t L, num_t B, int n, num_t Bn[n], num_t An[
 
   int dir = 1; // TODO: (m.dir or 1) * (m.charge or 1)
 
-  T* bbxtw = mad_tpsa_new(px, mad_tpsa_same);
-  T* bbytw = mad_tpsa_new(py, mad_tpsa_same);
+  T* bbxtw = mad_tpsa_newr(px, mad_tpsa_same);
+  T* bbytw = mad_tpsa_newr(py, mad_tpsa_same);
 
   mad_tpsa_scalar(bbxtw, Bn[n-1]);
   mad_tpsa_scalar(bbytw, An[n-1]);
 
   if (n > 2) {
-    T* bbytwt = mad_tpsa_new(py, mad_tpsa_same);
+    T* bbytwt = mad_tpsa_newr(py, mad_tpsa_same);
 
     for (int j = n-2; j >= 0; j--) {
       mad_tpsa_axypbvwpc(1,x,bbytw, -1,y,bbxtw, Bn[j], bbytwt);
@@ -85,3 +89,711 @@ mad_track_kick(T * restrict m[], num_t L, num_t B, int n, num_t Bn[n], num_t An[
   mad_tpsa_del(bbxtw);
 }
 
+#undef T
+
+// --- particle maps -----------------------------------------------------------
+
+// see madl_track.mad for the references of the maps. The loops are in local
+// functions taking restrict arrays, the only way for the compiler to vectorize
+// them over the particles.
+
+#define PAR     num_t *restrict x, num_t *restrict px, \
+                num_t *restrict y, num_t *restrict py, \
+                num_t *restrict t, num_t *restrict pt
+#define PAR_(p) p[0], p[1], p[2], p[3], p[4], p[5]
+
+enum { blk_sz = 64 }; // particles per block for the multipoles
+
+static inline num_t
+sinc (num_t x)
+{
+  return fabs(x) < 1e-10 ? 1 : sin(x)/x; // same as gmath.sinc
+}
+
+// multipole field by, bx of a block of particles (Horner scheme)
+static inline void
+mult_field (int n, const num_t *restrict x, const num_t *restrict y, int nmul,
+            const num_t bn[], const num_t an[],
+            num_t *restrict bx, num_t *restrict by)
+{
+  for (int i = 0; i < n; ++i)
+    by[i] = bn[nmul-1], bx[i] = an[nmul-1];
+
+  for (int j = nmul-2; j >= 0; --j)
+    for (int i = 0; i < n; ++i) {
+      const num_t byt = x[i]*by[i] - y[i]*bx[i] + bn[j];
+      bx[i] = y[i]*by[i] + x[i]*bx[i] + an[j];
+      by[i] = byt;
+    }
+}
+
+// --- rotations, translation
+
+static inline void
+srot (int n, PAR, num_t angle)
+{
+  (void)t, (void)pt;
+  const num_t sa = sin(angle), ca = cos(angle);
+
+  for (int i = 0; i < n; ++i) {
+    const num_t x_ = x[i], px_ = px[i], y_ = y[i], py_ = py[i];
+    x [i] = ca*x_  + sa*y_;
+    y [i] = ca*y_  - sa*x_;
+    px[i] = ca*px_ + sa*py_;
+    py[i] = ca*py_ - sa*px_;
+  }
+}
+
+static inline void
+yrot (int n, PAR, num_t angle, num_t beta)
+{
+  const num_t sa = sin(angle), ca = cos(angle), ta = tan(angle);
+  const num_t beta_inv = 1/beta;
+
+  for (int i = 0; i < n; ++i) {
+    const num_t x_  = x[i];
+    const num_t pz  = sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i] - px[i]*px[i]
+                                                              - py[i]*py[i]);
+    const num_t pz_ = 1/pz;
+    const num_t ptt = 1 - ta*px[i]*pz_;
+
+    x [i] = x_/(ca*ptt);
+    px[i] = ca*px[i] + sa*pz;
+    y [i] = y[i] + ta*x_*py[i]*pz_/ ptt;
+    t [i] = t[i] - ta*x_*pz_*(beta_inv+pt[i]) / ptt;
+  }
+}
+
+static inline void
+xrot (int n, PAR, num_t angle, num_t beta)
+{
+  const num_t sa = sin(angle), ca = cos(angle), ta = tan(angle);
+  const num_t beta_inv = 1/beta;
+
+  // same as yrot with x <-> y and px <-> py
+  for (int i = 0; i < n; ++i) {
+    const num_t y_  = y[i];
+    const num_t pz  = sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i] - px[i]*px[i]
+                                                              - py[i]*py[i]);
+    const num_t pz_ = 1/pz;
+    const num_t ptt = 1 - ta*py[i]*pz_;
+
+    x [i] = x[i] + ta*y_*px[i]*pz_/ptt;
+    y [i] = y_/(ca*ptt);
+    py[i] = ca*py[i] + sa*pz;
+    t [i] = t[i] - ta*y_*pz_*(beta_inv+pt[i]) / ptt;
+  }
+}
+
+static inline void
+trans (int n, PAR, num_t dx, num_t dy, num_t dz, num_t beta)
+{
+  const num_t beta_inv = 1/beta;
+
+  for (int i = 0; i < n; ++i) {
+    const num_t pz_ = 1/sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i] - px[i]*px[i]
+                                                                - py[i]*py[i]);
+    x[i] = x[i]-dx + dz*px[i]*pz_;
+    y[i] = y[i]-dy + dz*py[i]*pz_;
+    t[i] = t[i]-dz * (beta_inv+pt[i])*pz_;
+  }
+}
+
+// --- dipole fringe fields
+
+static inline void
+face (int n, PAR, num_t h, num_t k0, int dir, num_t beta)
+{
+  const num_t beta_inv = 1/beta;
+  const num_t w  = dir*k0*h/2;        // horizontal wedge (only dir)
+  const num_t wi = dir ==  1 ? w : 0; // entry
+  const num_t wo = dir == -1 ? w : 0; // exit
+
+  for (int i = 0; i < n; ++i) {
+    const num_t y2  = y[i]*y[i];
+    num_t       x_  = x[i];
+    num_t       px_ = px[i] + wi*(x_*x_);
+
+    const num_t ptt = sqrt(1 + 2*pt[i]*beta_inv + pt[i]*pt[i] - px_*px_);
+    const num_t xi  = dir*sqrt(1 + 2*pt[i]*beta_inv + pt[i]*pt[i])*k0*h/(ptt*ptt);
+    const num_t dxi_px   =  2*px_*xi/(ptt*ptt);
+    const num_t dxi_ddel = -2*xi*(1 + pt[i])/(ptt*ptt);
+
+    x_    = x_ / (1-dxi_px*y2);
+    px_   = px_ - xi*y2;
+    py[i] = py[i] - 2*xi*x_*y[i];
+    t [i] = t [i] - dxi_ddel*x_*y2;
+
+    x [i] = x_;
+    px[i] = px_ + wo*(x_*x_);
+  }
+}
+
+static inline void
+wedge (int n, PAR, num_t e, num_t b1, num_t beta)
+{
+  const num_t sa = sin(e), ca = cos(e), sa2 = sin(2*e);
+  const num_t beta_inv = 1/beta;
+
+  for (int i = 0; i < n; ++i) {
+    const num_t x_  = x[i], px_ = px[i];
+    const num_t pz  = sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i] - px_*px_
+                                                              - py[i]*py[i]);
+    const num_t pp  = 1 + 2*pt[i]*beta_inv + pt[i]*pt[i] - py[i]*py[i];
+    const num_t pxt = px_*ca + (pz - b1*x_)*sa;
+    const num_t ptt = sqrt(pp);
+    const num_t pzs = sqrt(pp - pxt*pxt);
+    const num_t yt  = (e + asin(px_/ptt) - asin(pxt/ptt)) / b1;
+
+    x [i] = x_*ca + (x_*px_*sa2 + sa*sa*(2*x_*pz-b1*x_*x_)) / (pzs+pz*ca-px_*sa);
+    px[i] = pxt;
+    y [i] = y[i] + py[i] * yt;
+    t [i] = t[i] - yt*(beta_inv + pt[i]);
+  }
+}
+
+static inline void
+fringe_dipole (int n, PAR, num_t b, num_t fint, num_t hgap, num_t beta)
+{
+  const num_t beta_inv = 1/beta;
+  const num_t fsad = fint*hgap != 0 ? 1/(fint*hgap*2)/36 : 0; // soft edge
+
+  for (int i = 0; i < n; ++i) {
+    const num_t pz = sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i] - px[i]*px[i]
+                                                             - py[i]*py[i]);
+    const num_t time_fac = beta_inv + pt[i];
+    const num_t rel_p    = sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i]);
+    const num_t c3       = b*b*fsad/rel_p;
+
+    const num_t xp  = px[i]/pz, yp = py[i]/pz;
+    const num_t xp2 = xp*xp, yp2 = yp*yp, xy = xp/(1 + yp2);
+
+    // matrix d
+    const num_t d11 = (1+xp2) / pz, d12 = xp*yp  / pz, d13 = -time_fac*xp /(pz*pz);
+    const num_t d21 =  xp*yp  / pz, d22 = (1+yp2)/ pz, d23 = -time_fac*yp /(pz*pz);
+    const num_t d31 = -xp         , d32 =   -yp      , d33 =  time_fac    / pz;
+
+    num_t fi0 = atan(xy)-2*b*fint*hgap*(1 + xp2*(2 + yp2))*pz;
+    const num_t cf0 = cos(fi0);
+    const num_t co2 = b/(cf0*cf0);
+    const num_t co1 = co2/(1 + xy*xy);
+
+    const num_t fi1 =    co1 /       (1 + yp2)     - 2*co2*b*fint*hgap* (2*xp*(2 + yp2)*pz);
+    const num_t fi2 =-2*co1*xp*yp/((1+yp2)*(1+yp2)) - 2*co2*b*fint*hgap* (2*xp2*yp)*pz;
+    const num_t fi3 =                               - 2*co2*b*fint*hgap* (1 + xp2*(2 + yp2));
+
+    fi0 = b*tan(fi0);
+
+    const num_t by = fi1*d12 + fi2*d22 + fi3*d32; // y column
+    const num_t bx = fi1*d11 + fi2*d21 + fi3*d31; // x column
+    const num_t bt = fi1*d13 + fi2*d23 + fi3*d33; // z column
+
+    const num_t y_ = 2*y[i]/(1 + sqrt(1 - 2*by*y[i]));
+    const num_t y2 = y_*y_;
+
+    y [i] = y_;
+    py[i] = py[i] - fi0*y_;
+    x [i] = x [i] + 0.5*bx*y2;
+    t [i] = t [i] + 0.5*bt*y2;
+
+    // soft edge
+    py[i] = py[i] - 4*c3*(y2*y_);
+    t [i] = t [i] +   c3*(y2*y2)/(rel_p*rel_p)*time_fac;
+  }
+}
+
+// --- drifts
+
+static inline void
+strait_drift (int n, PAR, num_t l, num_t T, num_t beta)
+{
+  const num_t beta_inv = 1/beta;
+  const num_t dt = (1-T)*l*beta_inv;
+
+  for (int i = 0; i < n; ++i) {
+    const num_t l_pz = l/sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i] - px[i]*px[i]
+                                                                 - py[i]*py[i]);
+    x[i] = x[i] + px[i]*l_pz;
+    y[i] = y[i] + py[i]*l_pz;
+    t[i] = t[i] - (beta_inv+pt[i])*l_pz + dt;
+  }
+}
+
+static inline void
+curved_drift (int n, PAR, num_t l, num_t rho, num_t T, num_t beta)
+{
+  const num_t beta_inv = 1/beta;
+  const num_t angle = l/rho;
+  const num_t sa = sin(angle), ca = cos(angle), ta = tan(angle), sa2 = sin(angle/2);
+  const num_t dt = (1-T)*l*beta_inv;
+
+  for (int i = 0; i < n; ++i) {
+    const num_t pz  = sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i] - px[i]*px[i]
+                                                              - py[i]*py[i]);
+    const num_t pz_ = 1/pz;
+    const num_t ptt = 1 - ta*px[i]*pz_;
+    const num_t xr  = x[i]+rho;
+
+    x [i] = (x[i] + rho*(2*(sa2*sa2) + sa*px[i]*pz_)) / (ca*ptt);
+    px[i] = ca*px[i] + sa*pz;
+    y [i] = y[i] + ta*xr*pz_*py[i]/ptt;
+    t [i] = t[i] - ta*xr*pz_*(beta_inv+pt[i]) / ptt + dt;
+  }
+}
+
+static inline void
+solenoid_drift (int n, PAR, num_t l, num_t bsol, num_t T, num_t beta)
+{
+  const num_t beta_inv = 1/beta;
+  const num_t bsol2 = bsol*bsol;
+  const num_t dt = (1-T)*l*beta_inv;
+
+  for (int i = 0; i < n; ++i) {
+    const num_t x_ = x[i], px_ = px[i], y_ = y[i], py_ = py[i];
+    const num_t xp = px_ + bsol*y_;
+    const num_t yp = py_ - bsol*x_;
+
+    const num_t l_pz  = l/sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i] - xp*xp - yp*yp);
+    const num_t angle = l_pz*bsol;
+
+    const num_t ca = cos(angle), sa = sin(angle), sc = sinc(angle);
+
+    const num_t xt  = ca*x_  + l_pz*sc*px_;
+    const num_t pxt = ca*px_ - l_pz*sc*x_ *bsol2;
+    const num_t yt  = ca*y_  + l_pz*sc*py_;
+    const num_t pyt = ca*py_ - l_pz*sc*y_ *bsol2;
+
+    x [i] = ca*xt  + sa*yt;
+    px[i] = ca*pxt + sa*pyt;
+    y [i] = ca*yt  - sa*xt;
+    py[i] = ca*pyt - sa*pxt;
+    t [i] = t[i] - (beta_inv+pt[i])*l_pz + dt;
+  }
+}
+
+// --- kicks
+
+static inline void
+thin_kick (int n, PAR, int nmul, const num_t bn[], const num_t an[],
+           num_t knl1, num_t ksl1, num_t lrad, num_t dirch, num_t beta)
+{
+  const num_t beta_inv = 1/beta;
+  const int   dipole   = knl1 != 0 || ksl1 != 0;
+  num_t bx[blk_sz], by[blk_sz];
+
+  for (int b = 0; b < n; b += blk_sz) {
+    const int m = MIN(blk_sz, n-b);
+    mult_field(m, x+b, y+b, nmul, bn, an, bx, by);
+
+    for (int k = 0; k < m; ++k) {
+      px[b+k] = px[b+k] - dirch*by[k] + dirch*knl1;
+      py[b+k] = py[b+k] + dirch*bx[k] - dirch*ksl1;
+    }
+
+    if (!dipole) continue;
+
+    for (int i = b; i < b+m; ++i) {
+      const num_t pz = sqrt(1 + 2*beta_inv*pt[i] + pt[i]*pt[i]);
+      if (lrad != 0) { // dipole focusing and deltap
+        px[i] = px[i] - knl1*knl1*x[i]/lrad + dirch*knl1*(pz-1);
+        py[i] = py[i] - ksl1*ksl1*y[i]/lrad + dirch*ksl1*(pz-1);
+      }
+      t[i] = t[i] - dirch*(knl1*x[i] - ksl1*y[i]) * (beta_inv+pt[i])/pz;
+    }
+  }
+}
+
+static inline void
+strait_kick (int n, PAR, int nmul, const num_t bn[], const num_t an[],
+             num_t dirch)
+{
+  (void)t, (void)pt;
+  num_t bx[blk_sz], by[blk_sz];
+
+  for (int b = 0; b < n; b += blk_sz) {
+    const int m = MIN(blk_sz, n-b);
+    mult_field(m, x+b, y+b, nmul, bn, an, bx, by);
+
+    for (int k = 0; k < m; ++k) {
+      px[b+k] = px[b+k] - dirch*by[k];
+      py[b+k] = py[b+k] + dirch*bx[k];
+    }
+  }
+}
+
+static inline void
+curved_kick (int n, PAR, int nmul, const num_t bn[], const num_t an[],
+             num_t k0, num_t dirch)
+{
+  (void)t, (void)pt;
+  num_t bx[blk_sz], by[blk_sz];
+
+  for (int b = 0; b < n; b += blk_sz) {
+    const int m = MIN(blk_sz, n-b);
+    mult_field(m, x+b, y+b, nmul, bn, an, bx, by);
+
+    for (int k = 0; k < m; ++k) {
+      px[b+k] = px[b+k] - dirch*by[k]*(1 + k0*x[b+k]);
+      py[b+k] = py[b+k] + dirch*bx[k]*(1 + k0*x[b+k]);
+    }
+  }
+}
+
+// --- thick elements
+
+// fused integration schedule of a thick element: nk kicks alternating with the
+// drifts d[], starting with a drift if dfirst, the kick k has its multipoles
+// bn = bk+2*k*nmul and an = bn+nmul. The schedule runs on blocks of particles
+// kept in cache over all the steps, the particles see the same operations in
+// the same order as with the steps run one by one on the bunch.
+
+enum { thk_sz = 4*blk_sz }; // particles per block for the schedules (L1)
+
+#define DRIFT(l)  switch (opc) { \
+  case track_strait_thick: \
+    strait_drift(m, PAR_(q), l, T, beta); break; \
+  case track_curved_thick: \
+    curved_drift(m, PAR_(q), l, p1, T, beta); break; \
+  default: \
+    if (p1 == 0) strait_drift  (m, PAR_(q), l,     T, beta); \
+    else         solenoid_drift(m, PAR_(q), l, p1, T, beta); \
+  }
+
+#define KICK(k)   do { const num_t *bn = bk+2*(k)*nmul, *an = bn+nmul; \
+  if (opc == track_curved_thick) curved_kick(m, PAR_(q), nmul, bn, an, p2, dirch); \
+  else                           strait_kick(m, PAR_(q), nmul, bn, an,     dirch); \
+  } while (0)
+
+static inline void
+thick (int n, num_t *p[6], int opc, int nk, int dfirst, const num_t d[],
+       int nmul, const num_t bk[], num_t T, num_t beta, num_t dirch,
+       num_t p1, num_t p2)
+{
+  for (int b = 0; b < n; b += thk_sz) {
+    const int m = MIN(thk_sz, n-b);
+    num_t *q[6] = { p[0]+b, p[1]+b, p[2]+b, p[3]+b, p[4]+b, p[5]+b };
+    int i = 0;
+
+    if (dfirst) DRIFT(d[i++]);
+    for (int k = 0; k < nk-1; ++k) {
+      KICK(k);
+      DRIFT(d[i++]);
+    }
+    KICK(nk-1);
+    if (dfirst) DRIFT(d[i]);
+  }
+}
+
+#undef DRIFT
+#undef KICK
+
+// --- interface
+
+void
+mad_track_srot (int n, num_t *p[6], num_t angle)
+{
+  assert(p);
+  srot(n, PAR_(p), angle);
+}
+
+void
+mad_track_xrot (int n, num_t *p[6], num_t angle, num_t beta)
+{
+  assert(p);
+  xrot(n, PAR_(p), angle, beta);
+}
+
+void
+mad_track_yrot (int n, num_t *p[6], num_t angle, num_t beta)
+{
+  assert(p);
+  yrot(n, PAR_(p), angle, beta);
+}
+
+void
+mad_track_trans (int n, num_t *p[6], num_t dx, num_t dy, num_t dz, num_t beta)
+{
+  assert(p);
+  trans(n, PAR_(p), dx, dy, dz, beta);
+}
+
+void
+mad_track_face (int n, num_t *p[6], num_t h, num_t k0, int dir, num_t beta)
+{
+  assert(p);
+  face(n, PAR_(p), h, k0, dir, beta);
+}
+
+void
+mad_track_wedge (int n, num_t *p[6], num_t e, num_t b1, num_t beta)
+{
+  assert(p);
+  if (b1 == 0) yrot (n, PAR_(p), e,     beta);
+  else         wedge(n, PAR_(p), e, b1, beta);
+}
+
+void
+mad_track_fringe_dipole (int n, num_t *p[6], num_t b, num_t fint, num_t hgap,
+                                                                     num_t beta)
+{
+  assert(p);
+  fringe_dipole(n, PAR_(p), b, fint, hgap, beta);
+}
+
+void
+mad_track_strait_drift (int n, num_t *p[6], num_t l, num_t T, num_t beta)
+{
+  assert(p);
+  strait_drift(n, PAR_(p), l, T, beta);
+}
+
+void
+mad_track_curved_drift (int n, num_t *p[6], num_t l, num_t rho, num_t T,
+                                                                 num_t beta)
+{
+  assert(p);
+  curved_drift(n, PAR_(p), l, rho, T, beta);
+}
+
+void
+mad_track_solenoid_drift (int n, num_t *p[6], num_t l, num_t bsol, num_t T,
+                                                                   num_t beta)
+{
+  assert(p);
+  if (bsol == 0) strait_drift  (n, PAR_(p), l,       T, beta);
+  else           solenoid_drift(n, PAR_(p), l, bsol, T, beta);
+}
+
+void
+mad_track_thin_kick (int n, num_t *p[6], int nmul, const num_t bn[nmul],
+                     const num_t an[nmul], num_t knl1, num_t ksl1,
+                     num_t lrad, num_t dirch, num_t beta)
+{
+  assert(p && bn && an && nmul > 0);
+  thin_kick(n, PAR_(p), nmul, bn, an, knl1, ksl1, lrad, dirch, beta);
+}
+
+void
+mad_track_strait_kick (int n, num_t *p[6], int nmul, const num_t bn[nmul],
+                       const num_t an[nmul], num_t dirch)
+{
+  assert(p && bn && an && nmul > 0);
+  strait_kick(n, PAR_(p), nmul, bn, an, dirch);
+}
+
+void
+mad_track_curved_kick (int n, num_t *p[6], int nmul, const num_t bn[nmul],
+                       const num_t an[nmul], num_t k0, num_t dirch)
+{
+  assert(p && bn && an && nmul > 0);
+  curved_kick(n, PAR_(p), nmul, bn, an, k0, dirch);
+}
+
+// --- apertures
+
+// particle inside the aperture, false for non-finite coordinates
+static inline int
+aper_in (num_t *p[6], int i, int kind, num_t ax, num_t ay)
+{
+  const num_t x = p[0][i], y = p[2][i];
+  if (!isfinite(p[1][i]+p[3][i]+p[4][i]+p[5][i])) return 0;
+  if (kind == track_aper_rectangle) return fabs(x) <= ax && fabs(y) <= ay;
+  return (x/ax)*(x/ax) + (y/ay)*(y/ay) <= 1; // circle and ellipse
+}
+
+static inline void
+swap_par (num_t *p[6], int *q[3], int i, int j)
+{
+  for (int k = 0; k < 6; ++k) { num_t t = p[k][i]; p[k][i] = p[k][j]; p[k][j] = t; }
+  for (int k = 0; k < 3; ++k) { int   t = q[k][i]; q[k][i] = q[k][j]; q[k][j] = t; }
+}
+
+// move the particles outside the aperture after the active ones (in place)
+static int
+aperture (int n, num_t *p[6], int *q[3], int turn, int elem,
+          int kind, num_t ax, num_t ay)
+{
+  for (int i = 0; i < n; )
+    if (aper_in(p, i, kind, ax, ay)) ++i;
+    else {
+      swap_par(p, q, i, --n);
+      q[1][n] = turn, q[2][n] = elem;
+    }
+  return n;
+}
+
+// --- programs
+
+// check the whole program once in the calling thread, hence prog never raises
+// errors (mad_error does not return and must not be called from the workers)
+static void
+prog_check (int nop, const track_op_t op[], const num_t coef_[], int *q_[3])
+{
+  for (int i = 0; i < nop; ++i) {
+    const int opc = op[i].opc, nm = op[i].nmul;
+    const num_t *a = op[i].a;
+
+    ensure(opc >= track_srot && opc <= track_aperture,
+           "invalid program (unknown operation %d at %d)", opc, i);
+    ensure(nm >= 0, "invalid program (negative multipoles at %d)", i);
+    ensure(nm == 0 || coef_, "invalid program (missing multipoles at %d)", i);
+
+    switch (opc) {
+    case track_thin_kick: case track_strait_kick: case track_curved_kick:
+      ensure(nm > 0, "invalid program (kick without multipoles at %d)", i);
+      break;
+    case track_strait_thick: case track_curved_thick: case track_solenoid_thick:
+      ensure(nm > 0 && (int)a[0] != 0, "invalid program (thick without kicks at %d)", i);
+      break;
+    case track_aperture:
+      ensure(q_, "invalid program (aperture without particle ids at %d)", i);
+      break;
+    default: break;
+    }
+  }
+}
+
+static int
+prog (int n, num_t *p[6], int *q_[3], int turn, int nop, const track_op_t op[],
+                                                        const num_t coef_[])
+{
+  for (int i = 0; i < nop; ++i) {
+    const num_t *a = op[i].a;
+    const num_t *bn = NULL, *an = NULL;
+    const int    nm = op[i].nmul;
+
+    if (nm > 0) bn = coef_ + op[i].ib, an = bn + nm;
+
+    switch (op[i].opc) {
+    case track_srot:
+      srot (n, PAR_(p), a[0]); break;
+    case track_xrot:
+      xrot (n, PAR_(p), a[0], a[1]); break;
+    case track_yrot:
+      yrot (n, PAR_(p), a[0], a[1]); break;
+    case track_trans:
+      trans(n, PAR_(p), a[0], a[1], a[2], a[3]); break;
+
+    case track_face:
+      face (n, PAR_(p), a[0], a[1], (int)a[2], a[3]); break;
+    case track_wedge:
+      if (a[1] == 0) yrot (n, PAR_(p), a[0],       a[2]);
+      else           wedge(n, PAR_(p), a[0], a[1], a[2]);
+      break;
+    case track_fringe_dipole:
+      fringe_dipole(n, PAR_(p), a[0], a[1], a[2], a[3]); break;
+
+    case track_strait_drift:
+      strait_drift(n, PAR_(p), a[0], a[1], a[2]); break;
+    case track_curved_drift:
+      curved_drift(n, PAR_(p), a[0], a[1], a[2], a[3]); break;
+    case track_solenoid_drift:
+      if (a[1] == 0) strait_drift  (n, PAR_(p), a[0],       a[2], a[3]);
+      else           solenoid_drift(n, PAR_(p), a[0], a[1], a[2], a[3]);
+      break;
+
+    case track_thin_kick:
+      thin_kick  (n, PAR_(p), nm, bn, an, a[0], a[1], a[2], a[3], a[4]); break;
+    case track_strait_kick:
+      strait_kick(n, PAR_(p), nm, bn, an, a[0]); break;
+    case track_curved_kick:
+      curved_kick(n, PAR_(p), nm, bn, an, a[0], a[1]); break;
+
+    case track_strait_thick: case track_curved_thick: case track_solenoid_thick: {
+      const int dfirst = a[0] > 0, nk = dfirst ? (int)a[0] : -(int)a[0];
+      const num_t *d = coef_ + op[i].ib, *bk = d + (dfirst ? nk+1 : nk-1);
+      thick(n, p, op[i].opc, nk, dfirst, d, nm, bk, a[1], a[2], a[3], a[4], a[5]);
+    } break;
+
+    case track_aperture:
+      n = aperture(n, p, q_, turn, (int)a[3], (int)a[0], a[1], a[2]); break;
+
+    default: break; // see prog_check
+    }
+  }
+  return n;
+}
+
+int
+mad_track_prog (int n, num_t *p[6], int *q_[3], int turn, int nop,
+                const track_op_t op[nop], const num_t coef_[])
+{
+  assert(p && op);
+  prog_check(nop, op, coef_, q_);
+  return prog(n, p, q_, turn, nop, op, coef_);
+}
+
+// --- parallel tracking
+
+// chunks are fixed by n and nchk only, and particles are independent, hence
+// the results do not depend on the number of threads nor on the scheduling.
+
+enum { chk_sz = 4*blk_sz }; // default particles per chunk
+
+static inline num_t
+wtime (void)
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return (num_t)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+int
+mad_track_prog_run (int n, num_t *p[6], int *q[3], int turn, int nop,
+                    const track_op_t op[nop], const num_t coef_[],
+                    int nturn, int nchk, track_stat_t *stat_)
+{
+  assert(p && q && op);
+  ensure(turn >= 0 && nturn >= 0, "invalid turn %d or number of turns %d",
+                                   turn, nturn);
+  prog_check(nop, op, coef_, q);
+  if (nchk <= 0) nchk = chk_sz;
+
+  int   nc = (n + nchk-1) / nchk, nthr = 1;
+  u64_t np = 0;
+  num_t t0 = wtime();
+
+#ifdef _OPENMP
+  if (nc > 1) nthr = MIN(nc, omp_get_max_threads());
+#endif
+
+  for (int i = 0; i < n; ++i) q[1][i] = -1; // active
+
+  // a chunk runs all its turns on its active particles, compacted in place,
+  // non-finite particles are lost at the end of the turn (element 0)
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1) reduction(+:np) if (nc > 1)
+  #endif
+  for (int c = 0; c < nc; ++c) {
+    int i = c*nchk, m = MIN(nchk, n-i);
+    num_t *pc[6] = { p[0]+i, p[1]+i, p[2]+i, p[3]+i, p[4]+i, p[5]+i };
+    int   *qc[3] = { q[0]+i, q[1]+i, q[2]+i };
+
+    for (int k = 0; k < nturn && m > 0; ++k) {
+      np += m;
+      m = prog(m, pc, qc, turn+k, nop, op, coef_);
+      m = aperture(m, pc, qc, turn+k, 0, track_aper_ellipse, INFINITY, INFINITY);
+    }
+  }
+
+  // gather the active particles of the chunks before the lost ones
+  int i = 0, j = n-1;
+  while (i < j)
+    if      (q[1][i] <  0) ++i;
+    else if (q[1][j] >= 0) --j;
+    else swap_par(p, q, i++, j--);
+  while (i < n && q[1][i] < 0) ++i;
+
+  if (stat_) {
+    stat_->pturn = np;
+    stat_->time  = wtime() - t0;
+    stat_->nthr  = nthr;
+    stat_->nchk  = nchk;
+  }
+  return i;
+}
+
+#undef PAR
+#undef PAR_
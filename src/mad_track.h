@@ -1,6 +1,8 @@
 #ifndef MAD_TRACK_H
 #define MAD_TRACK_H
 
+#include "mad_defs.h"
+
 // --- types -------------------------------------------------------------------
 
 struct tpsa;
@@ -14,5 +16,118 @@ void mad_track_kick (T * restrict m[], num_t L, num_t B, int n, num_t Bn[n], num
 
 #undef T
 
+// --- particle maps -----------------------------------------------------------
+
+/*
+  Maps of madl_track.mad applied to a bunch of n particles stored as arrays
+  (SoA), p[6] = { x, px, y, py, t, pt }, each of length n. The operations are
+  the same and in the same order as in the Lua maps, except that powers are
+  products. beta is the relativistic beta of the beam, T is 1 for total path.
+  The multipole coefficients are bn[j] = knl[j+1]/j! and an[j] = ksl[j+1]/j!,
+  j=0..nmul-1, scaled by the length weight for the thick kicks.
+*/
+
+void mad_track_srot           (int n, num_t *p[6], num_t angle);
+void mad_track_xrot           (int n, num_t *p[6], num_t angle, num_t beta);
+void mad_track_yrot           (int n, num_t *p[6], num_t angle, num_t beta);
+void mad_track_trans          (int n, num_t *p[6], num_t dx, num_t dy, num_t dz,
+                                                                    num_t beta);
+
+void mad_track_face           (int n, num_t *p[6], num_t h, num_t k0, int dir,
+                                                                    num_t beta);
+void mad_track_wedge          (int n, num_t *p[6], num_t e, num_t b1, num_t beta);
+void mad_track_fringe_dipole  (int n, num_t *p[6], num_t b, num_t fint,
+                                                   num_t hgap,      num_t beta);
+
+void mad_track_strait_drift   (int n, num_t *p[6], num_t l,            num_t T,
+                                                                    num_t beta);
+void mad_track_curved_drift   (int n, num_t *p[6], num_t l, num_t rho, num_t T,
+                                                                    num_t beta);
+void mad_track_solenoid_drift (int n, num_t *p[6], num_t l, num_t bsol,num_t T,
+                                                                    num_t beta);
+
+void mad_track_thin_kick      (int n, num_t *p[6], int nmul, const num_t bn[nmul],
+                               const num_t an[nmul], num_t knl1, num_t ksl1,
+                               num_t lrad, num_t dirch, num_t beta);
+void mad_track_strait_kick    (int n, num_t *p[6], int nmul, const num_t bn[nmul],
+                               const num_t an[nmul], num_t dirch);
+void mad_track_curved_kick    (int n, num_t *p[6], int nmul, const num_t bn[nmul],
+                               const num_t an[nmul], num_t k0, num_t dirch);
+
+// --- particle programs -------------------------------------------------------
+
+/*
+  A program is a flat array of particle maps with their parameters evaluated
+  once (see compile in madl_track.mad), run on a bunch by mad_track_prog. The
+  arguments a[] of an operation are the parameters of its map after p, in the
+  same order. The multipoles of the kicks are bn = coef+ib and an = bn+nmul.
+
+  The thick operations run the whole integration schedule of an element
+  (see madl_sympint.mad) with a[] = { nk, T, beta, dirch, p1, p2 }: nk kicks
+  alternating with drifts, starting with a drift if nk > 0 and with a kick
+  otherwise, the lengths of the drifts being stored at coef+ib followed by
+  the multipoles bn, an of each kick. The parameter p1 is rho (curved) or
+  bsol (solenoid), p2 is k0 (curved). The strait and solenoid thick use the
+  strait kick, the curved thick uses the curved drift and kick.
+
+  The aperture operation a[] = { kind, ax, ay, elem } checks the particles,
+  circle and ellipse use half axes ax, ay, rectangle uses half widths. The
+  particles outside or with non-finite coordinates are lost: they are moved
+  after the active ones (in-place compaction) and q[3] = { id, turn, elem }
+  is permuted with the coordinates, turn and elem being set to the turn and
+  the element of loss. Programs return the number of active particles.
+  Programs are checked once before they run (e.g. unknown operations, kicks
+  without multipoles, apertures without q), the errors are raised by the
+  calling thread, never by the workers of mad_track_prog_run.
+*/
+
+enum track_opc {
+  track_srot, track_xrot, track_yrot, track_trans,
+  track_face, track_wedge, track_fringe_dipole,
+  track_strait_drift, track_curved_drift, track_solenoid_drift,
+  track_thin_kick, track_strait_kick, track_curved_kick,
+  track_strait_thick, track_curved_thick, track_solenoid_thick,
+  track_aperture,
+};
+
+enum track_aper {
+  track_aper_circle, track_aper_ellipse, track_aper_rectangle,
+};
+
+typedef struct track_op track_op_t;
+
+struct track_op {
+  int   opc, nmul, ib;
+  num_t a[6];
+};
+
+int  mad_track_prog (int n, num_t *p[6], int *q_[3], int turn, int nop,
+                     const track_op_t op[nop], const num_t coef_[]);
+
+// --- parallel tracking -------------------------------------------------------
+
+/*
+  mad_track_prog_run runs nturn times a program on a bunch split in chunks of
+  nchk particles (0: default), each chunk being tracked over all turns by one
+  thread with dynamic scheduling, from turn to turn+nturn-1. The lost particles
+  are compacted per chunk, and the particles with non-finite coordinates are
+  lost at the end of each turn (element 0). The n particles must be active
+  on entry, on return the active ones come first and their q[1] (turn) is -1.
+  The results do not depend on the number of threads. The statistics pturn
+  counts the turns of the particles active at the start of each turn.
+*/
+
+typedef struct track_stat track_stat_t;
+
+struct track_stat {
+  u64_t pturn;      // number of particle-turns tracked
+  num_t time;       // wall time in seconds
+  int   nthr, nchk; // number of threads, particles per chunk
+};
+
+int  mad_track_prog_run (int n, num_t *p[6], int *q[3], int turn, int nop,
+                         const track_op_t op[nop], const num_t coef_[],
+                         int nturn, int nchk, track_stat_t *stat_);
+
 // -----------------------------------------------------------------------------
 #endif
@@ -0,0 +1,207 @@
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | Parallel map concatenation benchmark
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+
+  Purpose:
+  - measure mad_map_concat, mad_map_prefix and the map tree (see mad_map.h)
+    on a line of thin sextupoles and drifts, against the sequential
+    composition, for an increasing number of threads, and check that the
+    results do not depend on the number of threads.
+
+  Usage:
+    bench_concat [-n nelm] [-v nv] [-m mo]
+      -n nelm   number of element maps (default 1000)
+      -v nv     number of map variables (default 6)
+      -m mo     maximum order           (default 6)
+
+  Information:
+  - one row per number of threads with a header line starting with '#', the
+    sequential time (seq_s) is measured with one thread, rdiff is the norm of
+    the difference between the sequential and the parallel one-turn maps
+    relative to the norm of the sequential one.
+  - tree_s is the time to build the map tree and upd_s the time to update it
+    after a change of one leaf, followed by the maps to 4 observation points.
+  - same is 1 when the one-turn map, all the partial maps and the maps of the
+    tree are identical to the run with one thread.
+  - from mo >= 6 (without knobs) each composition runs the parallel compose,
+    nested in the parallel concat, prefix and tree, hence the default order. Set
+    OMP_NUM_THREADS > 1 on a single core machine to check several threads.
+
+ o----------------------------------------------------------------------------o
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mad_map.h"
+
+// --- timers -------------------------------------------------------------------
+
+static inline double
+now (void)
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+// --- lattice ------------------------------------------------------------------
+
+// element i is a drift of length l followed by a thin sextupole of strength k
+// (x' = x + l px, px' = px - k x'^2), with a small coupling to y.
+
+static map_t*
+elem (desc_t *d, int i)
+{
+  map_t *m = mad_map_newd(d, mad_tpsa_default);
+  mad_map_ident(m);
+
+  tpsa_t **t = mad_map_tpsa(m), *x2 = mad_tpsa_new(t[0], mad_tpsa_same);
+  num_t k = 0.1*(1 + i%7), l = 0.05 + 0.01*(i%3);
+
+  mad_tpsa_axpbypc(1, t[0], l, t[1], 0, t[0]);
+  mad_tpsa_mul    (t[0], t[0], x2);
+  mad_tpsa_axpbypc(1, t[1], -k, x2, 0, t[1]);
+  if (mad_map_len(m) > 2)
+    mad_tpsa_axpbypc(1, t[1], 1e-3*k, t[2], 0, t[1]);
+
+  mad_tpsa_del(x2);
+  return m;
+}
+
+// --- benchmark ----------------------------------------------------------------
+
+enum { max_var = 16, max_obs = 4 };
+
+static int
+same_map (const map_t *a, const map_t *b)
+{
+  return mad_map_nrm1(a, b) == 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int n = 1000, nv = 6, mo = 6;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-n") && i+1 < argc) n  = atoi(argv[++i]); else
+    if (!strcmp(argv[i], "-v") && i+1 < argc) nv = atoi(argv[++i]); else
+    if (!strcmp(argv[i], "-m") && i+1 < argc) mo = atoi(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [-n nelm] [-v nv] [-m mo]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (n < 1 || nv < 2 || nv > max_var || mo < 1) {
+    fprintf(stderr, "invalid number of elements %d, variables %d or order %d\n",
+            n, nv, mo);
+    return EXIT_FAILURE;
+  }
+
+  ord_t vo[max_var];
+  for (int i = 0; i < nv; ++i) vo[i] = mo;
+
+  desc_t *d = mad_desc_new(nv, vo, NULL, NULL);
+  map_t **m  = malloc(n * sizeof *m);
+  map_t **r  = malloc(n * sizeof *r), **r1 = malloc(n * sizeof *r1);
+  map_t  *s  = mad_map_newd(d, mad_tpsa_default), *t = mad_map_new(s, mad_tpsa_same);
+  map_t  *c  = mad_map_new(s, mad_tpsa_same), *c1 = mad_map_new(s, mad_tpsa_same);
+  for (int i = 0; i < n; ++i) {
+    m [i] = elem(d, i);
+    r [i] = mad_map_new(s, mad_tpsa_same);
+    r1[i] = mad_map_new(s, mad_tpsa_same);
+  }
+
+  // tree observation points and changed leaf
+  int pos[max_obs] = { MAX(n/4,1), MAX(n/2,1), MAX(3*n/4,1), n }, chg = n/3;
+  map_t *o[max_obs], *o1[max_obs], *e = elem(d, chg+1);
+  for (int k = 0; k < max_obs; ++k) {
+    o [k] = mad_map_new(s, mad_tpsa_same);
+    o1[k] = mad_map_new(s, mad_tpsa_same);
+  }
+
+  int maxthr = 1;
+#ifdef _OPENMP
+  maxthr = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+
+  // sequential reference
+  double t0 = now();
+  mad_map_copy(m[0], s);
+  for (int i = 1; i < n; ++i)
+    mad_map_compose(m[i], s, t), mad_map_copy(t, s);
+  double seq = now() - t0;
+
+  printf("# %6s %6s %4s %4s %10s %10s %10s %10s %10s %10s %4s\n",
+         "nthr", "nelm", "nv", "mo", "seq_s", "concat_s", "prefix_s",
+         "tree_s", "upd_s", "rdiff", "same");
+
+  for (int nthr = 1; nthr <= maxthr; nthr = nthr < maxthr ? MIN(2*nthr, maxthr) : nthr+1) {
+#ifdef _OPENMP
+    omp_set_num_threads(nthr);
+#endif
+    map_t *cc = nthr == 1 ? c1 : c, **rr = nthr == 1 ? r1 : r,
+          **oo = nthr == 1 ? o1 : o;
+
+    t0 = now();
+    mad_map_concat(n, (const map_t**)m, cc);
+    double con = now() - t0;
+
+    t0 = now();
+    mad_map_prefix(n, (const map_t**)m, rr);
+    double pre = now() - t0;
+
+    t0 = now();
+    map_tree_t *tr = mad_map_tree_new(s, n);
+    for (int i = 0; i < n; ++i) mad_map_tree_set(tr, i, m[i]);
+    mad_map_tree_update(tr);
+    double tre = now() - t0;
+
+    t0 = now();
+    mad_map_tree_set (tr, chg, e);
+    mad_map_tree_maps(tr, max_obs, pos, oo);
+    double upd = now() - t0;
+    mad_map_tree_del(tr);
+
+    int same = 1;
+    if (nthr > 1) {
+      same = same_map(c, c1);
+      for (int i = 0; i < n       && same; ++i) same = same_map(r[i], r1[i]);
+      for (int k = 0; k < max_obs && same; ++k) same = same_map(o[k], o1[k]);
+    }
+    printf("  %6d %6d %4d %4d %10.3f %10.3f %10.3f %10.3f %10.3f %10.3e %4d\n",
+           nthr, n, nv, mo, seq, con, pre, tre, upd,
+           mad_map_nrm1(s, cc) / mad_map_nrm1(s, NULL), same);
+  }
+
+  for (int i = 0; i < n; ++i) {
+    mad_map_del(m[i]); mad_map_del(r[i]); mad_map_del(r1[i]);
+  }
+  for (int k = 0; k < max_obs; ++k) {
+    mad_map_del(o[k]); mad_map_del(o1[k]);
+  }
+  mad_map_del(e);
+  mad_map_del(s); mad_map_del(t); mad_map_del(c); mad_map_del(c1);
+  free(m); free(r); free(r1);
+  mad_desc_del(d);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | GTPSA single vs double precision benchmark
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+
+  Purpose:
+  - track the 6D map of a thin FODO-like cell (drift, quadrupole and
+    sextupole kicks, see mad_track.c) through nturn turns with tpsa and
+    ftpsa, and compare their speed and accuracy.
+
+  Usage:
+    bench_ftpsa [-n nturn] [-m mo]
+      -n nturn  number of turns (default 1)
+      -m mo     run only maximum order mo (default 2..8)
+
+  Information:
+  - one row per order with a header line starting with '#', the relative
+    error is sum_i |m_i(float) - m_i(double)|_1 / sum_i |m_i(double)|_1.
+  - times are in ms for the whole tracking, spd is double/float time.
+  - high order coefficients grow with the number of turns and may overflow
+    the float range, giving nan errors (e.g. mo=7 after 10 turns).
+
+ o----------------------------------------------------------------------------o
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "mad_tpsa.h"
+#include "mad_ftpsa.h"
+
+// --- timers -------------------------------------------------------------------
+
+static inline double
+now (void)
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+// --- maps (same as mad_track.c for both precisions) ---------------------------
+
+#define FUN(P,name) mad_##P##_##name
+
+#define DEF_MAPS(P,T)                                                          \
+static void                                                                    \
+P##_drift (T *m[], num_t L, num_t B, num_t E)                                  \
+{                                                                              \
+  T *x = m[0], *px = m[1], *y = m[2], *py = m[3], *s = m[4], *ps = m[5];       \
+  T *t1 = FUN(P,new)(x, mad_tpsa_same);                                        \
+  T *t2 = FUN(P,new)(s, mad_tpsa_same);                                        \
+  FUN(P,ax2pby2pcz2)(1,ps, -1,px, -1,py, t1);                                  \
+  FUN(P,axpbypc)(2/B,ps, 1,t1, 1, t1);                                         \
+  FUN(P,invsqrt)(t1,L, t1);                                                    \
+  FUN(P,axypbzpc)(1,px,t1, 1,x, 0, x);                                         \
+  FUN(P,axypbzpc)(1,py,t1, 1,y, 0, y);                                         \
+  FUN(P,copy)(ps, t2);                                                         \
+  FUN(P,set0)(t2,1,1/B);                                                       \
+  FUN(P,axypbzpc)(1,t2,t1, 1,s, -E/B, s);                                      \
+  FUN(P,del)(t2);                                                              \
+  FUN(P,del)(t1);                                                              \
+}                                                                              \
+                                                                               \
+static void                                                                    \
+P##_kick (T *m[], num_t L, num_t B, int n, const num_t Bn[n], const num_t An[n])\
+{                                                                              \
+  T *x = m[0], *px = m[1], *y = m[2], *py = m[3], *ps = m[5];                  \
+  T *bx = FUN(P,new)(px, mad_tpsa_same);                                       \
+  T *by = FUN(P,new)(py, mad_tpsa_same);                                       \
+  T *bt = FUN(P,new)(py, mad_tpsa_same);                                       \
+  FUN(P,scalar)(bx, Bn[n-1]);                                                  \
+  FUN(P,scalar)(by, An[n-1]);                                                  \
+  for (int j = n-2; j >= 0; j--) {                                             \
+    FUN(P,axypbvwpc)(1,x,by, -1,y,bx, Bn[j], bt);                              \
+    FUN(P,axypbvwpc)(1,y,by,  1,x,bx, An[j], bx);                              \
+    T *tmp = by; by = bt; bt = tmp;                                            \
+  }                                                                            \
+  FUN(P,axpbypc)(1,px, -L,by, 0, px);                                          \
+  FUN(P,axpbypc)(1,py,  L,bx, 0, py);                                          \
+  FUN(P,axypbzpc)(1,ps,ps, 2/B,ps, 1, ps);                                     \
+  FUN(P,sqrt)(ps, ps);                                                         \
+  FUN(P,set0)(ps,1,-1);                                                        \
+  FUN(P,del)(bt);                                                              \
+  FUN(P,del)(by);                                                              \
+  FUN(P,del)(bx);                                                              \
+}                                                                              \
+                                                                               \
+static void                                                                    \
+P##_track (T *m[], int nturn)                                                  \
+{                                                                              \
+  static const num_t                                                           \
+    qf[3] = { 0, 0.1, 0 }, qd[3] = { 0, -0.1, 0 }, sx[3] = { 0, 0, 0.05 },    \
+    z [3] = { 0 };                                                             \
+  const num_t B = 0.9, E = 1;                                                  \
+  for (int t = 0; t < nturn; ++t) {                                            \
+    P##_kick (m, 1  , B, 3, qf, z);                                            \
+    P##_drift(m, 2.5, B, E);                                                   \
+    P##_kick (m, 0.5, B, 3, sx, z);                                            \
+    P##_drift(m, 2.5, B, E);                                                   \
+    P##_kick (m, 1  , B, 3, qd, z);                                            \
+    P##_drift(m, 5  , B, E);                                                   \
+  }                                                                            \
+}
+
+DEF_MAPS(tpsa , tpsa_t )
+DEF_MAPS(ftpsa, ftpsa_t)
+
+// --- benchmark ----------------------------------------------------------------
+
+enum { nv = 6 };
+
+static void
+run (FILE *out, int mo, int nturn)
+{
+  ord_t vo[nv] = { mo, mo, mo, mo, mo, mo };
+  desc_t *d = mad_desc_new(nv, vo, NULL, NULL);
+
+  tpsa_t *m[nv], *r[nv];
+  ftpsa_t *fm[nv];
+  for (int i = 0; i < nv; ++i) {
+    m [i] = mad_tpsa_newd (d, mo);
+    r [i] = mad_tpsa_newd (d, mo);
+    fm[i] = mad_ftpsa_newd(d, mo);
+  }
+
+  // double precision
+  for (int i = 0; i < nv; ++i) {
+    mad_tpsa_clear(m[i]);
+    mad_tpsa_seti (m[i], i+1, 0, 1);
+  }
+  double t0 = now();
+  tpsa_track(m, nturn);
+  double dt = now() - t0;
+
+  // single precision
+  for (int i = 0; i < nv; ++i) {
+    mad_ftpsa_clear(fm[i]);
+    mad_ftpsa_seti (fm[i], i+1, 0, 1);
+  }
+  t0 = now();
+  ftpsa_track(fm, nturn);
+  double ft = now() - t0;
+
+  // relative error
+  double nrm = 0, err = 0;
+  for (int i = 0; i < nv; ++i) {
+    mad_ftpsa_double(fm[i], r[i]);
+    mad_tpsa_sub(r[i], m[i], r[i]);
+    nrm += mad_tpsa_nrm1(m[i], NULL);
+    err += mad_tpsa_nrm1(r[i], NULL);
+  }
+
+  fprintf(out, "%4d %4d %6d %12.3f %12.3f %8.2f %12.3e\n",
+          mo, nturn, mad_desc_maxsize(d), dt*1e3, ft*1e3, dt/ft, err/nrm);
+
+  for (int i = 0; i < nv; ++i) {
+    mad_tpsa_del (m [i]);
+    mad_tpsa_del (r [i]);
+    mad_ftpsa_del(fm[i]);
+  }
+  mad_desc_del(d);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int nturn = 1, mo_rng[2] = { 2, 8 };
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-n") && i+1 < argc) nturn = atoi(argv[++i]); else
+    if (!strcmp(argv[i], "-m") && i+1 < argc) mo_rng[0] = mo_rng[1] = atoi(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [-n nturn] [-m mo]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  printf("# %2s %4s %6s %12s %12s %8s %12s\n",
+         "mo", "turn", "nc", "double_ms", "float_ms", "spd", "rel_err");
+  for (int mo = mo_rng[0]; mo <= mo_rng[1]; ++mo)
+    run(stdout, mo, nturn);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,52 @@
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | Log handlers of the GTPSA micro-benchmarks
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+
+  Purpose:
+  - provide the log handlers and levels normally provided by mad_main.c to
+    the benchmarks linked against libmad.a (see Makefile).
+
+ o----------------------------------------------------------------------------o
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+// --- log handlers -----------------------------------------------------------
+
+int mad_warn_count     = 0;
+int mad_info_level     = 0;
+int mad_trace_level    = 0;
+int mad_trace_location = 0;
+
+static void
+msg (const char *tag, const char *fn, const char *fmt, va_list va)
+{
+  fprintf(stderr, "%s%s: ", tag, fn ? fn : "?");
+  vfprintf(stderr, fmt, va);
+  fputc('\n', stderr);
+}
+
+void (mad_error) (const char *fn, const char *fmt, ...)
+{ va_list va; va_start(va, fmt); msg("error: ", fn, fmt, va); va_end(va); exit(EXIT_FAILURE); }
+
+void (mad_warn) (const char *fn, const char *fmt, ...)
+{ va_list va; va_start(va, fmt); msg("warning: ", fn, fmt, va); va_end(va); ++mad_warn_count; }
+
+void (mad_trace) (int lvl, const char *fn, const char *fmt, ...)
+{ if (lvl > mad_trace_level) return;
+  va_list va; va_start(va, fmt); msg("trace: ", fn, fmt, va); va_end(va); }
@@ -0,0 +1,158 @@
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | GTPSA NUMA placement benchmark
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+
+  Purpose:
+  - measure the parallel mul and compose of high order maps (mo >= 12 uses
+    the parallel mul) for each NUMA placement policy of the descriptor (see
+    mad_desc_numa in mad_desc.h).
+
+  Usage:
+    bench_numa [-t time] [-v nv] [-m mo] [-p policy]
+      -t time   minimum time per measure in seconds (default 0.2)
+      -v nv     number of map variables (default 6)
+      -m mo     maximum order           (default 12)
+      -p policy run only this policy    (default all: 0, 4, 1, 3, 7)
+
+  Information:
+  - one row per policy with a header line starting with '#', numa is the
+    placement applied (see mad_desc_info), times are in ms/op.
+  - pinning is done once per process, hence the policies without pinning
+    run first. Run each policy in its own process (-p) to compare them with
+    an OpenMP runtime binding the threads (e.g. OMP_PROC_BIND=close).
+  - on a single node, all policies are expected to give the same times.
+
+ o----------------------------------------------------------------------------o
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "mad_tpsa.h"
+#include "mad_desc_impl.h"
+
+// --- timers -------------------------------------------------------------------
+
+static inline double
+now (void)
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+// --- benchmark ----------------------------------------------------------------
+
+enum { max_var = 16 };
+
+static double min_time = 0.2;
+
+static void
+fill (tpsa_t *t, int seed, int lin)
+{
+  // x_lin + small nonlinear terms of all orders
+  desc_t *d = mad_tpsa_desc(t);
+  int nc = mad_desc_maxsize(d);
+  mad_tpsa_clear(t);
+  for (int i = 1; i < nc; ++i) {
+    ord_t o = d->ords[i];
+    mad_tpsa_seti(t, i, 0, (o == 1 ? 0.1 : 0.01) * sin(seed + 0.37*i) / o);
+  }
+  mad_tpsa_seti(t, lin, 0, 1);
+}
+
+static double  // ms/op
+time_op (int n, tpsa_t *a[], tpsa_t *b[], tpsa_t *c[], int compose)
+{
+  long   k = 0;
+  double t0 = now(), dt;
+  do {
+    if (compose)
+      mad_tpsa_compose(n, (const tpsa_t**)a, n, (const tpsa_t**)b, n, c);
+    else
+      mad_tpsa_mul(a[0], b[0], c[0]);
+    ++k, dt = now() - t0;
+  } while (dt < min_time);
+  return 1e3 * dt / k;
+}
+
+static void
+run (FILE *out, int nv, int mo, int policy)
+{
+  ord_t vo[max_var] = { 0 };
+  for (int i = 0; i < nv; ++i) vo[i] = mo;
+
+  mad_desc_numa = policy;
+  desc_t *d = mad_desc_new(nv, vo, NULL, NULL);
+
+  tpsa_t *a[max_var], *b[max_var], *c[max_var];
+  for (int i = 0; i < nv; ++i) {
+    a[i] = mad_tpsa_newd(d, mo); fill(a[i], i   , i+1);
+    b[i] = mad_tpsa_newd(d, mo); fill(b[i], i+nv, i+1);
+    c[i] = mad_tpsa_newd(d, mo);
+  }
+
+  time_op(nv, a, b, c, 0); // warm up
+  double mul = time_op(nv, a, b, c, 0);
+  double cmp = time_op(nv, a, b, c, 1);
+
+  fprintf(out, "%6d %4d %4d %4d %8d %10.3f %12.3f %12.3f\n",
+          policy, d->numa, nv, mo, d->nc, d->time, mul, cmp);
+
+  for (int i = 0; i < nv; ++i) {
+    mad_tpsa_del(a[i]); mad_tpsa_del(b[i]); mad_tpsa_del(c[i]);
+  }
+  mad_desc_del(d);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int nv = 6, mo = 12, policy = -1;
+  const int policies[] = { 0, desc_numa_ilv, desc_numa_pin,
+                           desc_numa_pin | desc_numa_local,
+                           desc_numa_pin | desc_numa_local | desc_numa_ilv };
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-t") && i+1 < argc) min_time = atof(argv[++i]); else
+    if (!strcmp(argv[i], "-v") && i+1 < argc) nv       = atoi(argv[++i]); else
+    if (!strcmp(argv[i], "-m") && i+1 < argc) mo       = atoi(argv[++i]); else
+    if (!strcmp(argv[i], "-p") && i+1 < argc) policy   = atoi(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [-t time] [-v nv] [-m mo] [-p policy]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (nv < 1 || nv > max_var) {
+    fprintf(stderr, "invalid number of variables %d (1..%d)\n", nv, max_var);
+    return EXIT_FAILURE;
+  }
+
+  printf("# %4s %4s %4s %4s %8s %10s %12s %12s\n",
+         "pol", "numa", "nv", "mo", "nc", "build_s", "mul_ms", "compose_ms");
+  if (policy >= 0)
+    run(stdout, nv, mo, policy);
+  else
+    for (size_t i = 0; i < sizeof policies/sizeof *policies; ++i)
+      run(stdout, nv, mo, policies[i]);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,328 @@
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | GTPSA micro-benchmarks
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+
+  Purpose:
+  - measure the C GTPSA engine over a grid of (nv, mo, nk): descriptor build,
+    mul, compose, minv, exp, sin and invsqrt.
+
+  Usage:
+    bench_tpsa [-o file] [-t time] [-c maxnc] [-v nv] [-m mo] [-k nk]
+      -o file   results file (default bench_tpsa.txt, '-' for none)
+      -t time   minimum time per measure in seconds (default 0.05)
+      -c maxnc  skip descriptors with more than maxnc coefficients (10000),
+                e.g. nv=8 above mo=7 (the skipped points are reported)
+      -v nv     run only nv map variables    (default 2..8)
+      -m mo     run only maximum order mo    (default 2..16)
+      -k nk     run only nk knobs of order 1 (default 0..2)
+                descriptors with knobs require nv*mo+nk < 32
+
+  Information:
+  - the results file has one row per descriptor and a header line starting
+    with '#' listing the columns, it can be read by loadtxt.mad.
+  - times are in ns/op, mul_gflop is the GFLOP-equivalent estimated from the
+    number of monomial products (upper bound with knobs), dsize is d->size in
+    bytes and tsize is the size of one GTPSA in bytes.
+  - *_spd is the speedup of all threads vs one thread (1 without OpenMP).
+  - the library counters of mad_prof.h are reset and printed after each
+    descriptor when the library is compiled with -DMAD_PROF=1.
+
+ o----------------------------------------------------------------------------o
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "mad_prof.h"
+#include "mad_tpsa.h"
+#include "mad_desc_impl.h"
+#include "mad_tpsa_impl.h"
+
+// --- parameters ---------------------------------------------------------------
+
+static double min_time = 0.05;
+static int    max_nc   = 10000;
+static int    nv_rng[2] = { 2,  8 };
+static int    mo_rng[2] = { 2, 16 };
+static int    nk_rng[2] = { 0,  2 };
+static int    nskip     = 0;
+
+enum { max_var = 16 };
+
+// --- timers -------------------------------------------------------------------
+
+static inline double
+now (void)
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static inline void
+set_threads (int all)
+{
+#ifdef _OPENMP
+  static int max_threads = 0;
+  if (!max_threads) max_threads = omp_get_max_threads();
+  omp_set_num_threads(all ? max_threads : 1);
+#else
+  (void)all;
+#endif
+}
+
+// --- fixtures -----------------------------------------------------------------
+
+struct bench {
+  desc_t *d;
+  int     n;                    // number of map variables
+  tpsa_t *a[max_var], *b[max_var], *c[max_var], *x, *r;
+};
+
+static void
+fill (tpsa_t *t, int seed, num_t a0, int lin)
+{
+  // a0 + x_lin + small nonlinear terms of all orders
+  desc_t *d = mad_tpsa_desc(t);
+  int nc = mad_desc_maxsize(d);
+  mad_tpsa_clear(t);
+  for (int i = 1; i < nc; ++i) {
+    ord_t o = d->ords[i];
+    if (o <= mad_tpsa_ord(t))
+      mad_tpsa_seti(t, i, 0, (o == 1 ? 0.1 : 0.01) * sin(seed + 0.37*i) / o);
+  }
+  if (lin > 0) mad_tpsa_seti(t, lin, 0, 1);
+  mad_tpsa_set0(t, 0, a0);
+}
+
+static void
+bench_init (struct bench *b, desc_t *d, int n)
+{
+  b->d = d; b->n = n;
+  ord_t mo = mad_desc_maxord(d);
+  for (int i = 0; i < n; ++i) {
+    b->a[i] = mad_tpsa_newd(d, mo); fill(b->a[i], i  , 0, i+1);
+    b->b[i] = mad_tpsa_newd(d, mo); fill(b->b[i], i+n, 0, i+1);
+    b->c[i] = mad_tpsa_newd(d, mo);
+  }
+  b->x = mad_tpsa_newd(d, mo); fill(b->x, 2*n, 1.5, 1);
+  b->r = mad_tpsa_newd(d, mo);
+}
+
+static void
+bench_fini (struct bench *b)
+{
+  for (int i = 0; i < b->n; ++i) {
+    mad_tpsa_del(b->a[i]); mad_tpsa_del(b->b[i]); mad_tpsa_del(b->c[i]);
+  }
+  mad_tpsa_del(b->x); mad_tpsa_del(b->r);
+}
+
+// --- operations ---------------------------------------------------------------
+
+enum { op_mul, op_compose, op_minv, op_exp, op_sin, op_invsqrt, op_num };
+
+static const char *op_name[op_num] = {
+  "mul", "compose", "minv", "exp", "sin", "invsqrt"
+};
+
+static void
+run_op (struct bench *b, int op)
+{
+  const tpsa_t **ma = (const tpsa_t**)b->a, **mb = (const tpsa_t**)b->b;
+
+  switch (op) {
+  case op_mul    : mad_tpsa_mul    (b->a[0], b->b[0], b->r);        break;
+  case op_compose: mad_tpsa_compose(b->n, ma, b->n, mb, b->n, b->c); break;
+  case op_minv   : mad_tpsa_minv   (b->n, ma, b->n, b->c);           break;
+  case op_exp    : mad_tpsa_exp    (b->a[0], b->r);                  break;
+  case op_sin    : mad_tpsa_sin    (b->a[0], b->r);                  break;
+  case op_invsqrt: mad_tpsa_invsqrt(b->x, 1, b->r);                  break;
+  default: assert(0);
+  }
+}
+
+static double  // ns/op
+time_op (struct bench *b, int op)
+{
+  run_op(b, op); // warm up
+
+  long   n = 0, rep = 1;
+  double t0 = now(), dt;
+  do {
+    for (long i = 0; i < rep; ++i) run_op(b, op);
+    n += rep, rep *= 2, dt = now() - t0;
+  } while (dt < min_time);
+
+  return 1e9 * dt / n;
+}
+
+static double
+mul_flops (const desc_t *d)
+{
+  // 2 flops per product of monomials with order sum <= mo (upper bound)
+  const idx_t *pi = d->ord2idx;
+  double pairs = 0;
+  for (int oa = 0; oa <= d->mo; ++oa)
+    for (int ob = 0; oa+ob <= d->mo; ++ob)
+      pairs += (double)(pi[oa+1]-pi[oa]) * (pi[ob+1]-pi[ob]);
+  return 2*pairs;
+}
+
+// --- driver -------------------------------------------------------------------
+
+static desc_t*
+make_desc (int nv, int mo, int nk)
+{
+  ord_t vo[max_var], ko[max_var];
+  for (int i = 0; i < nv; ++i) vo[i] = mo;
+  for (int i = 0; i < nk; ++i) ko[i] = 1;
+  return nk ? mad_desc_newk(nv, vo, NULL, NULL, nk, ko, 1)
+            : mad_desc_new (nv, vo, NULL, NULL);
+}
+
+static long
+binom (int n, int k)
+{
+  long r = 1;
+  for (int i = 1; i <= k; ++i) r = r * (n-k+i) / i;
+  return r;
+}
+
+static void
+skip (int nv, int mo, int nk, long nc, const char *why)
+{
+  printf("nv=%d mo=%2d nk=%d nc=%7ld skipped (%s)\n", nv, mo, nk, nc, why);
+  nskip += 1;
+}
+
+static void
+run (FILE *out, int nv, int mo, int nk)
+{
+  // estimate size before building (knobs add at most a factor nk+1)
+  long nc = binom(nv+mo, nv) * (nk+1);
+  if (nc > max_nc) { skip(nv, mo, nk, nc, "nc > maxnc, see -c"); return; }
+
+  // mad_desc_newk limits the sum of the variables orders
+  if (nk && nv*mo + nk >= (int)(CHAR_BIT * sizeof(bit_t))) {
+    skip(nv, mo, nk, nc, "nv*mo+nk too large"); return;
+  }
+
+  double t0 = now();
+  desc_t *d = make_desc(nv, mo, nk);
+  double tdesc = 1e3 * (now() - t0);
+
+  if (mad_desc_maxsize(d) > max_nc) {
+    skip(nv, mo, nk, mad_desc_maxsize(d), "nc > maxnc, see -c");
+    mad_desc_del(d); return;
+  }
+
+  struct bench b;
+  bench_init(&b, d, nv);
+  mad_prof_reset();
+
+  double ns[op_num], spd[op_num];
+  for (int op = 0; op < op_num; ++op) {
+    set_threads(0);
+    double ns1 = time_op(&b, op);
+    set_threads(1);
+    ns[op]  = time_op(&b, op);
+    spd[op] = ns1 / ns[op];
+  }
+
+  double gflop = mul_flops(d) / ns[op_mul];
+  size_t tsize = sizeof(tpsa_t) + mad_desc_maxsize(d) * sizeof(num_t);
+
+  printf("nv=%d mo=%2d nk=%d nc=%7d desc=%8.2fms dsize=%9zu", nv, mo, nk,
+         mad_desc_maxsize(d), tdesc, d->size);
+  for (int op = 0; op < op_num; ++op)
+    printf(" %s=%.0fns(x%.2f)", op_name[op], ns[op], spd[op]);
+  printf(" mul=%.3fGF\n", gflop);
+
+  if (out) {
+    fprintf(out, "%d %d %d %d %.6g %zu %zu %.6g", nv, mo, nk,
+            mad_desc_maxsize(d), tdesc, d->size, tsize, gflop);
+    for (int op = 0; op < op_num; ++op)
+      fprintf(out, " %.6g %.4g", ns[op], spd[op]);
+    fprintf(out, "\n");
+    fflush(out);
+  }
+
+  if (mad_prof_enabled) mad_prof_print(stdout);
+
+  bench_fini(&b);
+  mad_desc_del(d);
+}
+
+static void
+usage (const char *prog)
+{
+  fprintf(stderr, "usage: %s [-o file] [-t time] [-c maxnc] [-v nv] [-m mo] [-k nk]\n", prog);
+  exit(EXIT_FAILURE);
+}
+
+int
+main (int argc, char *argv[])
+{
+  const char *fname = "bench_tpsa.txt";
+
+  for (int i = 1; i < argc; ++i) {
+    if (argv[i][0] != '-' || !argv[i][1] || argv[i][2] || i+1 == argc) usage(argv[0]);
+    const char *arg = argv[++i];
+    switch (argv[i-1][1]) {
+    case 'o': fname    = arg;                                  break;
+    case 't': min_time = atof(arg);                            break;
+    case 'c': max_nc   = atoi(arg);                            break;
+    case 'v': nv_rng[0] = nv_rng[1] = atoi(arg);               break;
+    case 'm': mo_rng[0] = mo_rng[1] = atoi(arg);               break;
+    case 'k': nk_rng[0] = nk_rng[1] = atoi(arg);               break;
+    default : usage(argv[0]);
+    }
+  }
+
+  if (nv_rng[1] + nk_rng[1] > max_var) usage(argv[0]);
+
+  FILE *out = strcmp(fname, "-") ? fopen(fname, "w") : NULL;
+  if (strcmp(fname, "-") && !out) {
+    fprintf(stderr, "error: unable to open %s\n", fname);
+    return EXIT_FAILURE;
+  }
+
+  if (out) {
+    fprintf(out, "# nv mo nk nc desc_ms dsize tsize mul_gflop");
+    for (int op = 0; op < op_num; ++op)
+      fprintf(out, " %s_ns %s_spd", op_name[op], op_name[op]);
+    fprintf(out, "\n");
+  }
+
+  for (int nk = nk_rng[0]; nk <= nk_rng[1]; ++nk)
+  for (int nv = nv_rng[0]; nv <= nv_rng[1]; ++nv)
+  for (int mo = mo_rng[0]; mo <= mo_rng[1]; ++mo)
+    run(out, nv, mo, nk);
+
+  if (nskip)
+    printf("%d points skipped (maxnc=%d), not in the results\n", nskip, max_nc);
+
+  if (out) fclose(out);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,172 @@
+/*
+ o----------------------------------------------------------------------------o
+ |
+ | Parallel particle tracking benchmark
+ |
+ | Methodical Accelerator Design - Copyright CERN 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o----------------------------------------------------------------------------o
+
+  Purpose:
+  - measure the throughput of mad_track_prog_run (see mad_track.h) on a FODO
+    lattice with thin sextupoles and circular apertures, for an increasing
+    number of threads, and check that the results do not depend on the
+    number of threads.
+
+  Usage:
+    bench_track [-n npar] [-t nturn] [-c nchk] [-a amp] [-r rad]
+      -n npar   number of particles            (default 20000)
+      -t nturn  number of turns                (default 1000)
+      -c nchk   number of particles per chunk  (default 0, see mad_track.h)
+      -a amp    maximum initial amplitude in m (default 0.01)
+      -r rad    aperture radius in m           (default 0.02)
+
+  Information:
+  - one row per number of threads with a header line starting with '#', the
+    throughput is in particle-turns/s, lost is the number of lost particles.
+  - same is 1 when the coordinates, the ids and the turns and elements of
+    loss are identical to the run with one thread.
+  - the amplitudes are spread up to amp to lose the outer particles and
+    unbalance the chunks, the lost particles are removed by compaction.
+
+ o----------------------------------------------------------------------------o
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "mad_track.h"
+
+// --- lattice ------------------------------------------------------------------
+
+// FODO cell of 20 m, thick quadrupoles of 1 m in 4 slices (drift-kick-drift),
+// thin sextupoles next to the quadrupoles, beta of 0.9 and 6D time. The
+// apertures are checked at the exit of the quadrupoles (elements 1 and 4).
+
+enum { nslc = 4, max_op = 64 };
+
+static const num_t beta = 0.9, k1 = 0.15, k2l = 2;
+static num_t rad = 0.02;
+
+static int
+quad (track_op_t op[], int nop, int ib)
+{
+  const num_t l = 1.0/nslc;
+  for (int i = 0; i < nslc; ++i) {
+    op[nop++] = (track_op_t){ track_strait_drift, 0,  0, { l/2, 0, beta } };
+    op[nop++] = (track_op_t){ track_strait_kick , 2, ib, { 1 } };
+    op[nop++] = (track_op_t){ track_strait_drift, 0,  0, { l/2, 0, beta } };
+  }
+  return nop;
+}
+
+static int
+fodo (track_op_t op[], num_t coef[])
+{
+  // multipoles: bn then an, quadrupoles scaled by the slice length
+  const num_t kq = k1/nslc;
+  const num_t c[] = { 0,  kq, 0, 0,           // focusing   quadrupole (ib=0)
+                      0, -kq, 0, 0,           // defocusing quadrupole (ib=4)
+                      0, 0, k2l/2, 0, 0, 0 }; // sextupole             (ib=8)
+  memcpy(coef, c, sizeof c);
+
+  const track_op_t aper = { track_aperture, 0, 0, { track_aper_circle, rad, rad } };
+
+  int nop = 0;
+  nop = quad(op, nop, 0);
+  op[nop] = aper, op[nop++].a[3] = 1;
+  op[nop++] = (track_op_t){ track_thin_kick   , 3, 8, { 0, 0, 0, 1, beta } };
+  op[nop++] = (track_op_t){ track_strait_drift, 0, 0, { 9, 0, beta } };
+  nop = quad(op, nop, 4);
+  op[nop] = aper, op[nop++].a[3] = 4;
+  op[nop++] = (track_op_t){ track_thin_kick   , 3, 8, { 0, 0, 0,-1, beta } };
+  op[nop++] = (track_op_t){ track_strait_drift, 0, 0, { 9, 0, beta } };
+  return nop;
+}
+
+// --- benchmark ----------------------------------------------------------------
+
+static void
+init (int n, num_t *p[6], int *q[3], num_t amp)
+{
+  for (int i = 0; i < n; ++i) {
+    q[0][i] = i+1, q[1][i] = q[2][i] = 0;
+    num_t a = amp * (i+1) / n, f = 0.61803398875 * i;
+    p[0][i] = a*cos(f), p[1][i] = 0;
+    p[2][i] = a*sin(f), p[3][i] = 0;
+    p[4][i] = 0       , p[5][i] = 1e-4 * sin(3*f);
+  }
+}
+
+int
+main (int argc, char *argv[])
+{
+  int npar = 20000, nturn = 1000, nchk = 0;
+  num_t amp = 0.01;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-n") && i+1 < argc) npar  = atoi(argv[++i]); else
+    if (!strcmp(argv[i], "-t") && i+1 < argc) nturn = atoi(argv[++i]); else
+    if (!strcmp(argv[i], "-c") && i+1 < argc) nchk  = atoi(argv[++i]); else
+    if (!strcmp(argv[i], "-a") && i+1 < argc) amp   = atof(argv[++i]); else
+    if (!strcmp(argv[i], "-r") && i+1 < argc) rad   = atof(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [-n npar] [-t nturn] [-c nchk] [-a amp] [-r rad]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (npar < 1 || nturn < 0) {
+    fprintf(stderr, "invalid number of particles %d or turns %d\n", npar, nturn);
+    return EXIT_FAILURE;
+  }
+
+  track_op_t op[max_op];
+  num_t coef[16];
+  int nop = fodo(op, coef);
+
+  num_t *ref = malloc(6*npar * sizeof *ref), *cur = malloc(6*npar * sizeof *cur);
+  int   *qrf = malloc(3*npar * sizeof *qrf), *qcu = malloc(3*npar * sizeof *qcu);
+  num_t *pr[6], *pc[6];
+  int   *qr[3], *qc[3];
+  for (int k = 0; k < 6; ++k) pr[k] = ref + k*npar, pc[k] = cur + k*npar;
+  for (int k = 0; k < 3; ++k) qr[k] = qrf + k*npar, qc[k] = qcu + k*npar;
+
+  int maxthr = 1;
+#ifdef _OPENMP
+  maxthr = omp_get_max_threads();
+#endif
+
+  printf("# %6s %6s %6s %6s %8s %10s %14s %4s\n",
+         "nthr", "npar", "nturn", "nchk", "lost", "time_s", "pturn/s", "same");
+
+  for (int nthr = 1; nthr <= maxthr; nthr = nthr < maxthr ? MIN(2*nthr, maxthr) : nthr+1) {
+#ifdef _OPENMP
+    omp_set_num_threads(nthr);
+#endif
+    num_t **p = nthr == 1 ? pr : pc;
+    int   **q = nthr == 1 ? qr : qc;
+    init(npar, p, q, amp);
+
+    track_stat_t st;
+    int lost = npar - mad_track_prog_run(npar, p, q, 0, nop, op, coef,
+                                         nturn, nchk, &st);
+
+    int same = nthr == 1 || (!memcmp(ref, cur, 6*npar * sizeof *cur) &&
+                             !memcmp(qrf, qcu, 3*npar * sizeof *qcu));
+    printf("  %6d %6d %6d %6d %8d %10.3f %14.4g %4d\n", st.nthr, npar, nturn,
+           st.nchk, lost, st.time, st.pturn / st.time, same);
+  }
+
+  free(ref); free(cur); free(qrf); free(qcu);
+  return EXIT_SUCCESS;
+}